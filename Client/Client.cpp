@@ -3,22 +3,28 @@
 #include <chrono>
 
 #include "../Common/ClientHeartbeat.h"
+#include "../Common/Multicast.h"
 
 namespace Worms {
-    Client::Client(std::string player_name, char const *game_server, uint16_t server_port,
-                          char const *game_iface, uint16_t iface_port)
+    Client::Client(std::string player_name, std::string room, char const *game_server,
+                   uint16_t server_port, char const *game_iface, uint16_t iface_port,
+                   Reactor::Backend backend, std::optional<sockaddr_in6> const& group)
             : session_id{static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count())},
               player_name{std::move(player_name)},
+              room{std::move(room)},
               server_sock{gai_sock_factory(SOCK_DGRAM, game_server, server_port)},
+              group_sock{group.has_value() ? open_group_socket(*group) : -1},
               iface_sock{gai_sock_factory(SOCK_STREAM, game_iface, iface_port)},
               heartbeat_timer{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)},
-              epoll{heartbeat_timer},
+              reactor{make_reactor(backend, heartbeat_timer)},
               server_send_buff{server_sock},
               server_receive_buff{server_sock},
+              group_receive_buff{group_sock},
               iface_send_buff{iface_sock, INITIAL_IFACE_BUFF_CAP},
               iface_receive_buff{iface_sock} {
 
+        assert(this->room.empty() || !group.has_value());
         if (server_sock < 0 || iface_sock < 0)
             syserr(errno, "opening sockets");
         if (heartbeat_timer < 0)
@@ -32,11 +38,15 @@ namespace Worms {
         verify(fcntl(iface_sock, F_SETFL, O_NONBLOCK), "fcntl");
 
 
-        epoll.add_fd(server_sock);
-        epoll.add_fd(iface_sock);
-        epoll.watch_fd_for_input(heartbeat_timer);
-        epoll.watch_fd_for_input(server_sock);
-        epoll.watch_fd_for_input(iface_sock);
+        reactor->add_fd(server_sock);
+        reactor->add_fd(iface_sock);
+        reactor->watch_fd_for_input(heartbeat_timer);
+        reactor->watch_fd_for_input(server_sock);
+        reactor->watch_fd_for_input(iface_sock);
+        if (group_sock >= 0) {
+            reactor->add_fd(group_sock);
+            reactor->watch_fd_for_input(group_sock);
+        }
     }
 
     void Client::handle_iface_msg() {
@@ -51,18 +61,18 @@ namespace Worms {
     void Client::send_heartbeat() {
         server_send_buff.clear();
         ClientHeartbeat heartbeat{session_id, turn_direction, next_expected_event_no,
-                                  player_name};
+                                  player_name, room};
         heartbeat.pack(server_send_buff);
         if (!server_send_buff.flush())
-            epoll.watch_fd_for_output(server_sock);
+            reactor->watch_fd_for_output(server_sock);
     }
 
-    void Client::handle_events() {
-        assert(server_receive_buff.exhausted());
-        server_receive_buff.populate();
+    void Client::handle_events(UDPReceiveBuffer& receive_buff) {
+        assert(receive_buff.exhausted());
+        receive_buff.populate();
 
         uint32_t game_id;
-        server_receive_buff.unpack_field(game_id);
+        receive_buff.unpack_field(game_id);
         if (game_id != current_game_id &&
             previous_game_ids.find(game_id) == previous_game_ids.end()) {
             if (next_expected_event_no > 0)
@@ -73,9 +83,9 @@ namespace Worms {
         }
 
         try {
-            while (!server_receive_buff.exhausted()) {
+            while (!receive_buff.exhausted()) {
                 try {
-                    auto event = unpack_event(server_receive_buff);
+                    auto event = unpack_event(receive_buff);
 
                     if (event->event_no == next_expected_event_no) {
                         ++next_expected_event_no;
@@ -109,12 +119,12 @@ namespace Worms {
                 }
 
                 if (!iface_send_buff.flush()) {
-                    epoll.watch_fd_for_output(iface_sock);
+                    reactor->watch_fd_for_output(iface_sock);
                 }
             }
         } catch (Crc32Mismatch const &) {
             fputs("Crc32 mismatch!\n", stderr);
-            server_receive_buff.discard();
+            receive_buff.discard();
         }
     }
 
@@ -125,28 +135,33 @@ namespace Worms {
             verify(timerfd_settime(heartbeat_timer, 0, &conf, nullptr),
                    "timerfd_settime");
         }
-        struct epoll_event event{};
         for (;;) {
-            event = epoll.wait();
-            if (event.data.fd == heartbeat_timer) {
-                uint64_t expirations;
-                read(heartbeat_timer, &expirations, sizeof(expirations));
-                send_heartbeat();
-            } else if (event.events & EPOLLOUT) {
-                if (event.data.fd == server_sock) { // drain server queue
-                    drain_server_queue();
-                } else { // drain iface queue
-                    if (iface_send_buff.flush()) {
-                        epoll.stop_watching_fd_for_output(iface_sock);
-                    } // else keep us notified about iface socket possibility to send
+            for (auto const& event : reactor->wait()) {
+                if (event.data.fd == heartbeat_timer) {
+                    reactor->timer_expirations();
+                    send_heartbeat();
+                    continue;
+                }
+                if (event.events & EPOLLOUT) {
+                    if (event.data.fd == server_sock) { // drain server queue
+                        drain_server_queue();
+                    } else { // drain iface queue
+                        if (iface_send_buff.flush()) {
+                            reactor->stop_watching_fd_for_output(iface_sock);
+                        } // else keep us notified about iface socket possibility to send
+                    }
                 }
-            } else {
-                if (event.data.fd == server_sock) {
-                    // receive events from server
-                    handle_events();
-                } else {
-                    // receive pressed/released from interface
-                    handle_iface_msg();
+                if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    if (event.data.fd == server_sock) {
+                        // receive events from server
+                        handle_events(server_receive_buff);
+                    } else if (event.data.fd == group_sock) {
+                        // receive live events published to the group
+                        handle_events(group_receive_buff);
+                    } else {
+                        // receive pressed/released from interface
+                        handle_iface_msg();
+                    }
                 }
             }
         }
@@ -8,7 +8,7 @@
 #include <set>
 #include <vector>
 
-#include "../Common/Epoll.h"
+#include "../Common/Reactor.h"
 #include "../Common/Event.h"
 
 namespace Worms {
@@ -22,13 +22,17 @@ namespace Worms {
 
         uint64_t const session_id;
         std::string const player_name;
+        std::string const room;
         int const server_sock;
+        // Socket of the multicast group with live events, or -1 if none was joined.
+        int const group_sock;
         int const iface_sock;
         int const heartbeat_timer;
 
-        Epoll epoll;
+        std::unique_ptr<Reactor> reactor;
         UDPSendBuffer server_send_buff;
         UDPReceiveBuffer server_receive_buff;
+        UDPReceiveBuffer group_receive_buff;
         TCPSendBuffer iface_send_buff;
         TCPReceiveBuffer iface_receive_buff;
         uint8_t turn_direction = STRAIGHT;
@@ -41,11 +45,17 @@ namespace Worms {
 
 
     public:
-        Client(std::string player_name, char const *game_server, uint16_t server_port,
-               char const *game_iface, uint16_t iface_port);
+        /* Empty room means the server's default one. Given a multicast group,
+         * live events are received from it as well as from the server. Only events
+         * of the default room are published to the group, so it requires that room. */
+        Client(std::string player_name, std::string room, char const *game_server,
+               uint16_t server_port, char const *game_iface, uint16_t iface_port,
+               Reactor::Backend backend, std::optional<sockaddr_in6> const& group);
 
         ~Client() {
             close(server_sock);
+            if (group_sock >= 0)
+                close(group_sock);
             close(iface_sock);
             close(heartbeat_timer);
         }
@@ -60,12 +70,12 @@ namespace Worms {
         /* Should it happened that server socket clogged up,
          * here we later send the enqueued heartbeat after it becomes usable again. */
         void drain_server_queue() {
-            epoll.stop_watching_fd_for_output(server_sock);
+            reactor->stop_watching_fd_for_output(server_sock);
             server_send_buff.flush();
         }
 
         /* Receives and parses new events, then resends them to GUI. */
-        void handle_events();
+        void handle_events(UDPReceiveBuffer& receive_buff);
 
     public:
         /* Main client routine. Endless loop of sending heartbeat
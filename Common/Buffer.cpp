@@ -1,5 +1,7 @@
 #include "Buffer.h"
 
+#include <algorithm>
+
 namespace Worms {
     void TCPSendBuffer::pack_word(std::string const &s) {
         if (capacity - size < s.size() + 1)
@@ -178,6 +180,249 @@ namespace Worms {
         throw BadData{};
     }
 
+    UDPReceiveRing::UDPReceiveRing(int const sock, size_t const capacity)
+            : sock{sock}, senders(capacity), iovecs(capacity), headers(capacity) {
+        slots.reserve(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots.emplace_back(sock);
+            iovecs[i].iov_base = slots[i].buff;
+            iovecs[i].iov_len = MAX_DATA_SIZE;
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+            headers[i].msg_hdr.msg_name = &senders[i];
+        }
+    }
+
+    size_t UDPReceiveRing::populate() {
+        for (auto& header : headers) {
+            // Overwritten by every call, hence reset each time.
+            header.msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+        }
+        int res = recvmmsg(sock, headers.data(), headers.size(), MSG_DONTWAIT, nullptr);
+        if (res == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            syserr(errno, "recvmmsg");
+        }
+        for (int i = 0; i < res; ++i) {
+            slots[i].received(headers[i].msg_len);
+        }
+        return static_cast<size_t>(res);
+    }
+
+    void UDPReceiveRing::store(size_t const i, sockaddr_in6 const& sender,
+                               char const *data, size_t len) {
+        assert(i < slots.size());
+        len = std::min(len, static_cast<size_t>(MAX_DATA_SIZE));
+        senders[i] = sender;
+        memcpy(slots[i].buff, data, len);
+        slots[i].received(len);
+    }
+
+    namespace {
+        /* Smallest power of 2 not less than the capacity, which cannot overflow
+         * as the capacity is bounded. */
+        size_t round_capacity(size_t const capacity) {
+            size_t const bounded = std::clamp(capacity, size_t{1}, SendQueue::MAX_CAPACITY);
+            return bounded == 1 ? 1 : size_t{1} << (64 - __builtin_clzll(bounded - 1));
+        }
+    }
+
+    SendQueue::SendQueue(size_t const capacity, size_t const max_capacity)
+            : max_capacity{round_capacity(max_capacity)} {
+        assert(max_capacity <= MAX_CAPACITY);
+        size_t const rounded = round_capacity(std::min(capacity, max_capacity));
+        slots.resize(rounded);
+        mask = rounded - 1;
+    }
+
+    size_t SendQueue::drop_catch_up(size_t const max) {
+        // Survivors are compacted towards the front, in their order.
+        size_t dropped = 0;
+        size_t kept = pinned;
+        for (size_t i = pinned; i < count; ++i) {
+            auto& datagram = at(i);
+            if (dropped < max && !datagram.live) {
+                datagram.owner.reset();
+                ++dropped;
+            } else {
+                if (kept != i)
+                    at(kept) = std::move(datagram);
+                ++kept;
+            }
+        }
+        count = kept;
+        counters.dropped += dropped;
+        return dropped;
+    }
+
+    void SendQueue::grow() {
+        std::vector<QueuedDatagram> grown(slots.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(at(i));
+        }
+        slots = std::move(grown);
+        mask = slots.size() - 1;
+        head = 0;
+    }
+
+    bool SendQueue::make_room(bool const live) {
+        if (count < slots.size())
+            return true;
+        // Dropping a batch at once keeps the cost of compaction amortized.
+        if (drop_catch_up(std::max<size_t>(1, slots.size() / 16)) > 0)
+            return true;
+        if (!live || slots.size() == max_capacity) {
+            ++counters.dropped;
+            if (live)
+                ++counters.dropped_live;
+            return false;
+        }
+        grow();
+        return true;
+    }
+
+    void SendQueue::append(QueuedDatagram&& datagram) {
+        at(count) = std::move(datagram);
+        ++count;
+        counters.high_water = std::max(counters.high_water, count);
+    }
+
+    void SendQueue::push_back(QueuedDatagram datagram) {
+        if (!make_room(datagram.live))
+            return;
+        ++(datagram.live ? counters.live : counters.catch_up);
+        append(std::move(datagram));
+    }
+
+    void SendQueue::move_to(SendQueue& other) {
+        assert(pinned == 0);
+        if (other.empty() && other.capacity() == capacity()) {
+            std::swap(slots, other.slots);
+            std::swap(head, other.head);
+            std::swap(count, other.count);
+            other.counters.high_water = std::max(other.counters.high_water, other.count);
+        } else {
+            distribute([&other](sockaddr_in6 const&) -> SendQueue& {
+                return other;
+            });
+        }
+    }
+
+    SendQueue::Counters SendQueue::take_counters() {
+        Counters const taken = counters;
+        counters = Counters{};
+        return taken;
+    }
+
+    UDPBatchSender::UDPBatchSender(int const sock) : sock{sock} {
+        // Segmentation offload is used only if the kernel supports it.
+        int segment_size;
+        socklen_t len = sizeof(segment_size);
+        gso_enabled = getsockopt(sock, SOL_UDP, UDP_SEGMENT, &segment_size, &len) == 0;
+    }
+
+    size_t UDPBatchSender::gso_segments(SendQueue const& queue, size_t const first,
+                                        size_t const max_segments) const {
+        auto const& head = queue[first];
+        size_t const segment_size = head.size();
+        size_t count = 1;
+        while (count < max_segments && first + count < queue.size()) {
+            auto const& next = queue[first + count];
+            if (memcmp(&next.destination, &head.destination, sizeof(head.destination)) != 0 ||
+                next.size() > segment_size)
+                break;
+            ++count;
+            if (next.size() < segment_size)
+                break; // only the last segment may be shorter
+        }
+        return count;
+    }
+
+    size_t UDPBatchSender::prepare(SendQueue& queue) {
+        size_t messages = 0;
+        size_t queued = 0;
+        size_t used_iovecs = 0;
+        while (messages < BATCH && queued < queue.size() &&
+               used_iovecs + IOVECS_PER_DATAGRAM <= IOVECS) {
+            size_t const max_segments = (IOVECS - used_iovecs) / IOVECS_PER_DATAGRAM;
+            size_t const count = gso_enabled ?
+                    gso_segments(queue, queued, std::min(GSO_MAX_SEGMENTS, max_segments)) : 1;
+            auto const& head = queue[queued];
+            auto& header = headers[messages].msg_hdr;
+            header = msghdr{};
+            destinations[messages] = head.destination;
+            header.msg_name = &destinations[messages];
+            header.msg_namelen = sizeof(head.destination);
+            header.msg_iov = &iovecs[used_iovecs];
+            header.msg_iovlen = count * IOVECS_PER_DATAGRAM;
+            for (size_t i = 0; i < count; ++i) {
+                auto const& datagram = queue[queued + i];
+                iovec *parts = &iovecs[used_iovecs + i * IOVECS_PER_DATAGRAM];
+                parts[0].iov_base = const_cast<char *>(datagram.header);
+                parts[0].iov_len = datagram.header_size;
+                parts[1].iov_base = const_cast<char *>(datagram.body);
+                parts[1].iov_len = datagram.body_size;
+            }
+            if (count > 1) {
+                // Datagram boundaries are kept, as all but the last one are segment-sized.
+                header.msg_control = controls[messages].buf;
+                header.msg_controllen = sizeof(controls[messages].buf);
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                auto const segment_size = static_cast<uint16_t>(head.size());
+                memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+            }
+            segments[messages] = count;
+            ++messages;
+            queued += count;
+            used_iovecs += count * IOVECS_PER_DATAGRAM;
+        }
+        queue.pin_front(queued);
+        return messages;
+    }
+
+    void UDPBatchSender::complete(SendQueue& queue, size_t const sent) {
+        for (size_t i = 0; i < sent; ++i) {
+            datagrams_sent += segments[i];
+            for (size_t j = 0; j < segments[i]; ++j)
+                queue.pop_front();
+        }
+        queue.unpin();
+    }
+
+    bool UDPBatchSender::fallback(int const err) {
+        if (gso_enabled && (err == EIO || err == EINVAL)) {
+            // The route does not support segmentation offload after all.
+            gso_enabled = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool UDPBatchSender::send(SendQueue& queue) {
+        while (!queue.empty()) {
+            size_t const messages = prepare(queue);
+            int const sent = sendmmsg(sock, headers.data(), messages, 0);
+            ++syscalls;
+            if (sent == -1) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    queue.unpin();
+                    return false;
+                }
+                if (fallback(errno))
+                    continue;
+                syserr(errno, "cannot send to remote host (UDP)");
+            }
+            // The batch may have been sent only partially; the rest is retried
+            // in the next iteration, where a clogged socket will report EAGAIN.
+            complete(queue, sent);
+        }
+        return true;
+    }
+
     bool UDPSendBuffer::flush() {
         ssize_t res;
         if (receiver.has_value())
@@ -2,12 +2,17 @@
 #define ROBAKI_BUFFER_H
 
 #include <arpa/inet.h>
+#include <netinet/udp.h>
 #include <cassert>
 #include <cstring>
 #include <unistd.h>
 
+#include <array>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Crc32Computer.h"
 #include "err.h"
@@ -71,7 +76,7 @@ namespace Worms {
             size = res;
         }
 
-        [[nodiscard]] sockaddr_in6 address() const {
+        [[nodiscard]] sockaddr_in6 const& address() const {
             return _address;
         }
 
@@ -89,6 +94,9 @@ namespace Worms {
         std::optional<UDPEndpoint> receiver;
 
     public:
+        /* Buffer used only for staging data, which is sent by other means. */
+        UDPSendBuffer() = default;
+
         explicit UDPSendBuffer(int receiver_sock)
                 : receiver_sock{receiver_sock} {}
 
@@ -103,6 +111,10 @@ namespace Worms {
             return MAX_DATA_SIZE - _size;
         }
 
+        [[nodiscard]] char const *data() const {
+            return buff;
+        }
+
         void clear() {
             _size = 0;
         }
@@ -128,7 +140,199 @@ namespace Worms {
         }
     };
 
+    /* Datagram awaiting sending, made of a header and a body, which are not copied,
+     * but borrowed from memory kept alive by owner, shared by many datagrams.
+     * Live datagrams carry events just generated; the others help clients catch up. */
+    struct QueuedDatagram {
+        sockaddr_in6 destination;
+        std::shared_ptr<void const> owner;
+        char const *header = nullptr;
+        uint16_t header_size = 0;
+        char const *body = nullptr;
+        uint16_t body_size = 0;
+        bool live = false;
+
+        [[nodiscard]] size_t size() const {
+            return header_size + body_size;
+        }
+    };
+
+    /* FIFO of datagrams awaiting sending: a ring of slots, all allocated up front.
+     * Once it is full, the oldest catch-up datagrams are dropped to make room, as their
+     * clients ask for them again anyway. If the ring is full of live datagrams, it grows,
+     * but never past its maximum capacity, which bounds its memory. Beyond that, new
+     * live datagrams are dropped too, and their clients catch up like lagging ones do.
+     * Datagrams pinned at the front are being sent, so they are never dropped. */
+    class SendQueue {
+    public:
+        static constexpr size_t const DEFAULT_CAPACITY = 1 << 14;
+        static constexpr size_t const MAX_CAPACITY = 1 << 20;
+
+        struct Counters {
+            uint64_t live = 0;
+            uint64_t catch_up = 0;
+            // Datagrams dropped, live ones among them.
+            uint64_t dropped = 0;
+            uint64_t dropped_live = 0;
+            size_t high_water = 0;
+        };
+
+    private:
+        std::vector<QueuedDatagram> slots;
+        size_t mask;
+        size_t max_capacity;
+        size_t head = 0;
+        size_t count = 0;
+        size_t pinned = 0;
+        Counters counters;
+
+        QueuedDatagram& at(size_t const i) {
+            return slots[(head + i) & mask];
+        }
+
+        /* Drops up to max oldest catch-up datagrams which are not pinned.
+         * Returns the number of datagrams dropped. */
+        size_t drop_catch_up(size_t max);
+
+        void grow();
+
+        /* Makes room for another datagram, dropping some if necessary.
+         * Returns false if it is the new datagram that has to be dropped. */
+        bool make_room(bool live);
+
+        void append(QueuedDatagram&& datagram);
+
+    public:
+        /* Both capacities, at most MAX_CAPACITY, are rounded up to powers of 2.
+         * The initial one is cut down to the maximum one if it exceeds it. */
+        explicit SendQueue(size_t capacity = DEFAULT_CAPACITY,
+                           size_t max_capacity = MAX_CAPACITY);
+
+        [[nodiscard]] size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return slots.size();
+        }
+
+        QueuedDatagram const& operator[](size_t const i) const {
+            assert(i < count);
+            return slots[(head + i) & mask];
+        }
+
+        void push_back(QueuedDatagram datagram);
+
+        void pop_front() {
+            assert(count > 0);
+            at(0).owner.reset();
+            head = (head + 1) & mask;
+            --count;
+            if (pinned > 0)
+                --pinned;
+        }
+
+        /* Moves all datagrams out of this queue to the back of the other one.
+         * They are counted only once, by the queue they were pushed to. */
+        void move_to(SendQueue& other);
+
+        /* Like move_to(), but each datagram goes to the queue chosen by its destination. */
+        template<typename Choose>
+        void distribute(Choose const& choose) {
+            assert(pinned == 0);
+            for (size_t i = 0; i < count; ++i) {
+                auto& datagram = at(i);
+                SendQueue& other = choose(datagram.destination);
+                if (other.make_room(datagram.live))
+                    other.append(std::move(datagram));
+            }
+            while (count > 0) {
+                pop_front();
+            }
+        }
+
+        /* Protects the first n datagrams from being dropped until they are unpinned. */
+        void pin_front(size_t const n) {
+            assert(n <= count);
+            pinned = n;
+        }
+
+        void unpin() {
+            pinned = 0;
+        }
+
+        /* Returns counters gathered since the previous call. */
+        Counters take_counters();
+    };
+
+    /* Turns the front of a SendQueue into a batch of messages for sendmmsg (or any other
+     * batched submission), coalescing same-destination bursts with UDP GSO if available. */
+    class UDPBatchSender {
+    public:
+        static constexpr size_t const BATCH = 64;
+    private:
+        static constexpr size_t const GSO_MAX_SEGMENTS = 64;
+        static constexpr size_t const IOVECS = 1024;
+        static constexpr size_t const IOVECS_PER_DATAGRAM = 2; // header and body
+
+        /* Control message carrying UDP_SEGMENT size, properly aligned. */
+        union GsoControl {
+            char buf[CMSG_SPACE(sizeof(uint16_t))];
+            cmsghdr align;
+        };
+
+        int const sock;
+        bool gso_enabled;
+        std::array<mmsghdr, BATCH> headers{};
+        // Destinations are copied, as the queue may move its slots while they are sent.
+        std::array<sockaddr_in6, BATCH> destinations{};
+        std::array<iovec, IOVECS> iovecs{};
+        std::array<GsoControl, BATCH> controls{};
+        std::array<size_t, BATCH> segments{};
+
+    public:
+        uint64_t syscalls = 0;
+        uint64_t datagrams_sent = 0;
+
+        explicit UDPBatchSender(int sock);
+
+        [[nodiscard]] int socket() const {
+            return sock;
+        }
+
+        /* Fills headers with up to BATCH messages built from the front of the queue,
+         * pinning their datagrams there until complete(). Returns their number. */
+        size_t prepare(SendQueue& queue);
+
+        [[nodiscard]] mmsghdr *messages() {
+            return headers.data();
+        }
+
+        /* Pops datagrams of the first `sent` prepared messages from the queue
+         * and unpins the remaining ones. */
+        void complete(SendQueue& queue, size_t sent);
+
+        /* Reacts to a failed send. Returns true if the failure was caused
+         * by segmentation offload, which is then disabled, so the send can be retried. */
+        bool fallback(int err);
+
+        /* Sends the queue with sendmmsg until it is empty or the socket clogs up.
+         * Returns false in the latter case. */
+        bool send(SendQueue& queue);
+
+    private:
+        /* Counts how many enqueued datagrams, starting from the given one, can be sent
+         * as a single UDP GSO message: all of them must share the destination and,
+         * except for the last one, be of equal size, which becomes the segment size. */
+        size_t gso_segments(SendQueue const& queue, size_t first, size_t max_segments) const;
+    };
+
     class UDPReceiveBuffer {
+        friend class UDPReceiveRing;
     private:
         int const sock;
         char buff[MAX_DATA_SIZE]{};
@@ -136,6 +340,11 @@ namespace Worms {
         size_t pos;
         std::optional<UDPEndpoint> sender;
 
+        void received(size_t len) {
+            size = len;
+            pos = 0;
+        }
+
     public:
         explicit UDPReceiveBuffer(int const sock) : sock{sock}, size{0}, pos{0} {}
 
@@ -169,14 +378,55 @@ namespace Worms {
 
         std::string unpack_name();
 
-        void unpack_remaining(std::string& s) {
-            while (pos < size)
-                s.push_back(buff[pos++]);
+        /* The view is valid until the buffer receives another datagram. */
+        std::string_view unpack_remaining() {
+            std::string_view const rest{buff + pos, size - pos};
+            pos = size;
+            return rest;
         }
 
         void verify_crc32(uint32_t len_before, uint32_t len_after);
     };
 
+    /* Set of UDPReceiveBuffer slots filled by a single recvmmsg call,
+     * so that a burst of datagrams costs one system call instead of one per datagram. */
+    class UDPReceiveRing {
+    private:
+        int const sock;
+        std::vector<UDPReceiveBuffer> slots;
+        std::vector<sockaddr_in6> senders;
+        std::vector<iovec> iovecs;
+        std::vector<mmsghdr> headers;
+
+    public:
+        UDPReceiveRing(int sock, size_t capacity);
+
+        [[nodiscard]] int socket() const {
+            return sock;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return slots.size();
+        }
+
+        /* Receives pending datagrams into consecutive slots, starting from the first one.
+         * Returns the number of filled slots, 0 if there was nothing to receive. */
+        size_t populate();
+
+        /* Fills the slot with a datagram received by other means. */
+        void store(size_t i, sockaddr_in6 const& sender, char const *data, size_t len);
+
+        UDPReceiveBuffer& slot(size_t i) {
+            assert(i < slots.size());
+            return slots[i];
+        }
+
+        [[nodiscard]] sockaddr_in6 const& sender(size_t i) const {
+            assert(i < senders.size());
+            return senders[i];
+        }
+    };
+
     class TCPSendBuffer {
     private:
         int const sock;
@@ -1,28 +1,104 @@
 #ifndef ROBAKI_CLIENTHEARTBEAT_H
 #define ROBAKI_CLIENTHEARTBEAT_H
 
+#include <cstring>
+
+#include <algorithm>
+#include <string_view>
 #include <utility>
 
 #include "Buffer.h"
 
 namespace Worms {
-    struct ClientHeartbeat {
+    /* Heartbeat as received, its names pointing into the receive buffer, so that
+     * parsing it copies nothing. It is valid until the buffer receives another datagram.
+     * Names are split as in ClientHeartbeat. */
+    struct ClientHeartbeatView {
         uint64_t session_id{};
         uint8_t turn_direction{};
         uint32_t next_expected_event_no{};
-        std::string player_name;
+        std::string_view player_name;
+        std::string_view room;
 
-        ClientHeartbeat(uint64_t session_id, uint8_t turn_direction,
-                        uint32_t next_expected_event_no, std::string player_name)
+        ClientHeartbeatView(uint64_t session_id, uint8_t turn_direction,
+                            uint32_t next_expected_event_no, std::string_view player_name,
+                            std::string_view room)
                 : session_id{session_id}, turn_direction{turn_direction},
                   next_expected_event_no{next_expected_event_no},
-                  player_name{std::move(player_name)} {}
+                  player_name{player_name}, room{room} {}
 
-        explicit ClientHeartbeat(UDPReceiveBuffer &buff) {
+        explicit ClientHeartbeatView(UDPReceiveBuffer &buff) {
             buff.unpack_field(session_id);
             buff.unpack_field(turn_direction);
             buff.unpack_field(next_expected_event_no);
-            buff.unpack_remaining(player_name);
+            player_name = buff.unpack_remaining();
+            size_t const separator = player_name.find('\0');
+            if (separator != std::string_view::npos) {
+                room = player_name.substr(separator + 1);
+                player_name = player_name.substr(0, separator);
+            }
+        }
+
+        /* Names may be at most 20 characters long, each of them printable ASCII.
+         * Characters are checked eight at a time, as bytes of a machine word. */
+        [[nodiscard]] static bool is_valid_name(std::string_view const name) {
+            constexpr uint64_t const ONES = ~0ull / 255;
+            constexpr uint64_t const HIGH_BITS = ONES * 128;
+            if (name.size() > 20)
+                return false;
+            for (size_t pos = 0; pos < name.size(); pos += sizeof(uint64_t)) {
+                // Bytes past the end are filled with '!', which is valid.
+                uint64_t word = ONES * '!';
+                memcpy(&word, name.data() + pos, std::min(sizeof(word), name.size() - pos));
+                uint64_t const below_33 = (word - ONES * 33) & ~word & HIGH_BITS;
+                uint64_t const above_126 = ((word + ONES * (127 - 126)) | word) & HIGH_BITS;
+                if ((below_33 | above_126) != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool has_valid_player_name() const {
+            return is_valid_name(player_name) && is_valid_name(room);
+        }
+    };
+
+    /* Heartbeat may be extended with the name of a room to play in, following
+     * the player name after a '\0'. Without it, the client plays in the default room,
+     * whose name is empty, so plain heartbeats of the original protocol still work. */
+    struct ClientHeartbeat {
+        uint64_t session_id{};
+        uint8_t turn_direction{};
+        uint32_t next_expected_event_no{};
+        std::string player_name;
+        std::string room;
+
+        ClientHeartbeat(uint64_t session_id, uint8_t turn_direction,
+                        uint32_t next_expected_event_no, std::string player_name,
+                        std::string room = {})
+                : session_id{session_id}, turn_direction{turn_direction},
+                  next_expected_event_no{next_expected_event_no},
+                  player_name{std::move(player_name)}, room{std::move(room)} {}
+
+        explicit ClientHeartbeat(ClientHeartbeatView const& view)
+                : session_id{view.session_id}, turn_direction{view.turn_direction},
+                  next_expected_event_no{view.next_expected_event_no},
+                  player_name{view.player_name}, room{view.room} {}
+
+        explicit ClientHeartbeat(UDPReceiveBuffer &buff)
+                : ClientHeartbeat{ClientHeartbeatView{buff}} {}
+
+        [[nodiscard]] ClientHeartbeatView view() const {
+            return ClientHeartbeatView{session_id, turn_direction, next_expected_event_no,
+                                       player_name, room};
+        }
+
+        [[nodiscard]] static bool is_valid_name(std::string_view const name) {
+            return ClientHeartbeatView::is_valid_name(name);
+        }
+
+        [[nodiscard]] bool has_valid_player_name() const {
+            return view().has_valid_player_name();
         }
 
         void pack(UDPSendBuffer &buff) const {
@@ -30,6 +106,10 @@ namespace Worms {
             buff.pack_field(turn_direction);
             buff.pack_field(next_expected_event_no);
             buff.pack_string(player_name);
+            if (!room.empty()) {
+                buff.pack_field('\0');
+                buff.pack_string(room);
+            }
         }
     };
 }
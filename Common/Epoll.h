@@ -6,34 +6,52 @@
 #include <sys/epoll.h>
 #include <cassert>
 
-#include <map>
+#include <utility>
+#include <vector>
 
 #include "err.h"
+#include "Reactor.h"
 
 
 namespace Worms {
-    class Epoll {
+    class Epoll : public Reactor {
     private:
-        using flags_t = unsigned int;
+        using flags_t = uint32_t;
+
+        /* Per-fd bookkeeping, indexed directly by fd. */
+        struct Watched {
+            bool added = false;
+            flags_t flags = 0;
+        };
 
         int const epoll_fd;
         int const timerfd;
-        std::map<int, flags_t> watching;
+        flags_t const trigger_mode;
+        std::vector<Watched> watching;
+        std::vector<struct epoll_event> ready;
 
     public:
-        explicit Epoll(int const timerfd) : epoll_fd{epoll_create(1)}, timerfd{timerfd} {
+        /* In edge-triggered mode, an fd is reported only once per readiness change,
+         * so the caller must consume it until EAGAIN before waiting again. */
+        explicit Epoll(int const timerfd, bool const edge_triggered = false)
+                : epoll_fd{epoll_create(1)}, timerfd{timerfd},
+                  trigger_mode{edge_triggered ? static_cast<flags_t>(EPOLLET) : 0} {
             add_fd(timerfd);
         }
 
-        ~Epoll() {
+        ~Epoll() override {
             close(epoll_fd);
         }
 
-        void add_fd(int const fd) {
-            assert(watching.find(fd) == watching.end());
-            watching[fd] = 0;
+        void add_fd(int const fd) override {
+            assert(fd >= 0);
+            if (static_cast<size_t>(fd) >= watching.size())
+                watching.resize(fd + 1);
+            assert(!watching[fd].added);
+            watching[fd] = Watched{true, 0};
+            ready.emplace_back();
             struct epoll_event events{
-                .events = 0,
+                .events = trigger_mode,
                 .data{.fd = fd}
             };
             verify(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &events),
@@ -41,55 +59,82 @@ namespace Worms {
         }
 
     private:
+        Watched& watched(int const fd) {
+            assert(fd >= 0 && static_cast<size_t>(fd) < watching.size());
+            assert(watching[fd].added);
+            return watching[fd];
+        }
+
         void modify_watching(int const fd) {
             struct epoll_event event{
-                    .events = watching[fd],
+                    .events = watching[fd].flags | trigger_mode,
                     .data{.fd = fd}
             };
             verify(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event), "epoll_ctl");
         }
 
     public:
-        void watch_fd_for_input(int const fd) {
-            assert(watching.find(fd) != watching.end());
-            assert(!(watching[fd] & EPOLLIN));
-            watching[fd] |= EPOLLIN;
+        void watch_fd_for_input(int const fd) override {
+            auto& w = watched(fd);
+            assert(!(w.flags & EPOLLIN));
+            w.flags |= EPOLLIN;
             modify_watching(fd);
         }
 
-        void stop_watching_fd_for_input(int const fd) {
-            assert(watching.find(fd) != watching.end());
-            assert(watching[fd] & EPOLLIN);
-            watching[fd] &= ~EPOLLIN;
+        void stop_watching_fd_for_input(int const fd) override {
+            auto& w = watched(fd);
+            assert(w.flags & EPOLLIN);
+            w.flags &= ~EPOLLIN;
             modify_watching(fd);
         }
 
-        void watch_fd_for_output(int const fd) {
-            assert(watching.find(fd) != watching.end());
-            if (watching[fd] & EPOLLOUT)
+        void watch_fd_for_output(int const fd) override {
+            auto& w = watched(fd);
+            if (w.flags & EPOLLOUT)
                 return;
-            watching[fd] |= EPOLLOUT;
+            w.flags |= EPOLLOUT;
             modify_watching(fd);
         }
 
-        void stop_watching_fd_for_output(int const fd) {
-            assert(watching.find(fd) != watching.end());
-            assert(watching[fd] & EPOLLOUT);
-            watching[fd] &= ~EPOLLOUT;
+        void stop_watching_fd_for_output(int const fd) override {
+            auto& w = watched(fd);
+            assert(w.flags & EPOLLOUT);
+            w.flags &= ~EPOLLOUT;
             modify_watching(fd);
         }
 
-        struct epoll_event wait(int const timeout = -1) {
-            int max_events = static_cast<int>(watching.size());
-            struct epoll_event events[max_events];
-
-            verify(epoll_wait(epoll_fd, events, max_events, timeout), "epoll_wait");
+        void watch_for_datagrams(UDPReceiveRing& ring) override {
+            watch_fd_for_input(ring.socket());
+        }
 
-            for (int i = 0; i < max_events; ++i) {
-                if (events[i].data.fd == timerfd)
-                    return events[i];
+        ReadySet wait() override {
+            int const res = epoll_wait(epoll_fd, ready.data(),
+                                       static_cast<int>(ready.size()), -1);
+            verify(res, "epoll_wait");
+            auto const ready_num = static_cast<size_t>(res);
+
+            for (size_t i = 1; i < ready_num; ++i) {
+                if (ready[i].data.fd == timerfd) {
+                    std::swap(ready[0], ready[i]);
+                    break;
+                }
             }
-            return events[0];
+            return ReadySet{ready.data(), ready.data() + ready_num};
+        }
+
+        uint64_t timer_expirations() override {
+            uint64_t expirations;
+            if (read(timerfd, &expirations, sizeof(expirations)) == -1)
+                return 0;
+            return expirations;
+        }
+
+        size_t receive(UDPReceiveRing& ring) override {
+            return ring.populate();
+        }
+
+        bool send(UDPBatchSender& sender, SendQueue& queue) override {
+            return sender.send(queue);
         }
     };
 }
@@ -3,6 +3,7 @@
 
 #include <numeric>
 #include <memory>
+#include <vector>
 
 #include "Buffer.h"
 #include "Crc32Computer.h"
@@ -55,9 +56,10 @@ namespace Worms {
         virtual void pack_name(TCPSendBuffer& buff) const = 0;
     };
 
+    /* Final, as are all event data types, so that calls on concrete events are not virtual. */
     template<typename EventData,
             typename = std::enable_if_t<std::is_base_of_v<EventDataIface, EventData>>>
-    struct EventImpl : public Event {
+    struct EventImpl final : public Event {
 
         EventData event_data;
         uint32_t crc32{};
@@ -106,7 +108,7 @@ namespace Worms {
     /* NEW_GAME */
     constexpr uint8_t const NEW_GAME_NUM = 0;
 
-    struct Data_NEW_GAME : public EventDataIface {
+    struct Data_NEW_GAME final : public EventDataIface {
         uint32_t maxx{};
         uint32_t maxy{};
         std::vector<std::string> players;
@@ -162,7 +164,7 @@ namespace Worms {
 
     /* PIXEL */
     constexpr uint8_t const PIXEL_NUM = 1;
-    struct Data_PIXEL : public EventDataIface {
+    struct Data_PIXEL final : public EventDataIface {
         uint8_t player_number{};
         uint32_t x{};
         uint32_t y{};
@@ -210,7 +212,7 @@ namespace Worms {
 
     /* PLAYER_ELIMINATED */
     constexpr uint8_t const PLAYER_ELIMINATED_NUM = 2;
-    struct Data_PLAYER_ELIMINATED : public EventDataIface {
+    struct Data_PLAYER_ELIMINATED final : public EventDataIface {
         uint8_t player_number{};
 
         explicit Data_PLAYER_ELIMINATED(uint8_t player_number) : player_number{player_number} {}
@@ -246,7 +248,7 @@ namespace Worms {
 
     /* GAME_OVER */
     constexpr uint8_t const GAME_OVER_NUM = 3;
-    struct Data_GAME_OVER : public EventDataIface {
+    struct Data_GAME_OVER final : public EventDataIface {
         Data_GAME_OVER() = default;
 
         Data_GAME_OVER(UDPReceiveBuffer&, uint32_t) {}
@@ -0,0 +1,384 @@
+#include "IoUring.h"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace Worms {
+    namespace {
+        uint64_t encode(uint32_t kind, uint32_t value) {
+            return static_cast<uint64_t>(kind) << 32 | value;
+        }
+
+        void *map_ring(int ring_fd, size_t size, off_t offset) {
+            void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring_fd, offset);
+            if (ptr == MAP_FAILED)
+                syserr(errno, "mmap io_uring");
+            return ptr;
+        }
+    }
+
+    IoUring::IoUring(int const timerfd)
+            : ring_fd{-1}, timerfd{timerfd}, recv_buffers(RECV_BUFFERS * RECV_BUFFER_SIZE) {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = CQ_ENTRIES;
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, SQ_ENTRIES, &params));
+        if (ring_fd < 0)
+            syserr(errno, "io_uring_setup");
+
+        sq_ptr_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ptr_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_ptr_size = cq_ptr_size = std::max(sq_ptr_size, cq_ptr_size);
+            sq_ptr = cq_ptr = map_ring(ring_fd, sq_ptr_size, IORING_OFF_SQ_RING);
+        } else {
+            sq_ptr = map_ring(ring_fd, sq_ptr_size, IORING_OFF_SQ_RING);
+            cq_ptr = map_ring(ring_fd, cq_ptr_size, IORING_OFF_CQ_RING);
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map_ring(ring_fd, sqes_size, IORING_OFF_SQES));
+
+        auto *sq = static_cast<char *>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_entries = params.sq_entries;
+        sq_local_tail = *sq_tail;
+
+        auto *cq = static_cast<char *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // Buffers the kernel picks from when receiving datagrams.
+        provide_buffers(0, RECV_BUFFERS);
+
+        recv_msg.msg_namelen = sizeof(sockaddr_in6);
+
+        add_fd(timerfd);
+        watching[timerfd].by_completion = true;
+        arm_timer_read();
+    }
+
+    IoUring::~IoUring() {
+        // Closing the ring cancels all requests still in flight.
+        close(ring_fd);
+        munmap(sqes, sqes_size);
+        if (cq_ptr != sq_ptr)
+            munmap(cq_ptr, cq_ptr_size);
+        munmap(sq_ptr, sq_ptr_size);
+    }
+
+    IoUring::Watched& IoUring::watched(int const fd) {
+        assert(fd >= 0 && static_cast<size_t>(fd) < watching.size());
+        assert(watching[fd].added);
+        return watching[fd];
+    }
+
+    void IoUring::add_fd(int const fd) {
+        assert(fd >= 0);
+        if (static_cast<size_t>(fd) >= watching.size())
+            watching.resize(fd + 1);
+        assert(!watching[fd].added);
+        watching[fd].added = true;
+    }
+
+    void IoUring::watch_fd_for_input(int const fd) {
+        auto& w = watched(fd);
+        assert(!(w.flags & EPOLLIN));
+        w.flags |= EPOLLIN;
+    }
+
+    void IoUring::stop_watching_fd_for_input(int const fd) {
+        auto& w = watched(fd);
+        assert(w.flags & EPOLLIN);
+        w.flags &= ~EPOLLIN;
+    }
+
+    void IoUring::watch_fd_for_output(int const fd) {
+        watched(fd).flags |= EPOLLOUT;
+    }
+
+    void IoUring::stop_watching_fd_for_output(int const fd) {
+        auto& w = watched(fd);
+        assert(w.flags & EPOLLOUT);
+        w.flags &= ~EPOLLOUT;
+    }
+
+    void IoUring::watch_for_datagrams(UDPReceiveRing& ring) {
+        assert(recv_sock == -1);
+        recv_sock = ring.socket();
+        auto& w = watched(recv_sock);
+        w.by_completion = true;
+        w.flags |= EPOLLIN;
+    }
+
+    io_uring_sqe& IoUring::next_sqe() {
+        if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+            enter(0); // make room by submitting what is already there
+        unsigned const index = sq_local_tail & sq_mask;
+        sq_array[index] = index;
+        ++sq_local_tail;
+        io_uring_sqe& sqe = sqes[index];
+        sqe = io_uring_sqe{};
+        return sqe;
+    }
+
+    void IoUring::enter(unsigned const min_complete) {
+        __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+        unsigned const to_submit = sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (to_submit == 0 && min_complete == 0)
+            return;
+        long res = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                           min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (res == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            syserr(errno, "io_uring_enter");
+    }
+
+    void IoUring::arm_poll(int const fd, Request const kind) {
+        io_uring_sqe& sqe = next_sqe();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = fd;
+        sqe.poll32_events = kind == POLL_IN ? POLLIN : POLLOUT;
+        sqe.user_data = encode(kind, fd);
+        (kind == POLL_IN ? watching[fd].polling_in : watching[fd].polling_out) = true;
+    }
+
+    void IoUring::arm_timer_read() {
+        io_uring_sqe& sqe = next_sqe();
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = timerfd;
+        sqe.addr = reinterpret_cast<uint64_t>(&timer_value);
+        sqe.len = sizeof(timer_value);
+        sqe.user_data = encode(TIMER_READ, 0);
+    }
+
+    void IoUring::arm_receiving() {
+        io_uring_sqe& sqe = next_sqe();
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.fd = recv_sock;
+        sqe.addr = reinterpret_cast<uint64_t>(&recv_msg);
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = RECV_BUFFER_GROUP;
+        sqe.user_data = encode(RECV, 0);
+        receiving = true;
+    }
+
+    void IoUring::provide_buffers(uint16_t const first_id, uint16_t const num) {
+        io_uring_sqe& sqe = next_sqe();
+        sqe.opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe.fd = num;
+        sqe.addr = reinterpret_cast<uint64_t>(recv_buffers.data() + first_id * RECV_BUFFER_SIZE);
+        sqe.len = RECV_BUFFER_SIZE;
+        sqe.off = first_id;
+        sqe.buf_group = RECV_BUFFER_GROUP;
+        sqe.flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe.user_data = encode(PROVIDE_BUFFERS, 0);
+    }
+
+    void IoUring::mark_ready(int const fd, flags_t const events) {
+        for (auto& event : ready) {
+            if (event.data.fd == fd) {
+                event.events |= events;
+                return;
+            }
+        }
+        ready.push_back(epoll_event{.events = events, .data{.fd = fd}});
+    }
+
+    void IoUring::handle_completion(io_uring_cqe const& cqe) {
+        auto const kind = static_cast<Request>(cqe.user_data >> 32);
+        auto const value = static_cast<uint32_t>(cqe.user_data);
+        switch (kind) {
+            case POLL_IN:
+            case POLL_OUT: {
+                int const fd = static_cast<int>(value);
+                auto& w = watching[fd];
+                // The sender's socket is polled for output only once it has clogged up;
+                // should the poll fail, sending is just tried again.
+                if (kind == POLL_OUT && sender != nullptr && fd == sender->socket())
+                    send_completed = true;
+                flags_t const direction = kind == POLL_IN ? EPOLLIN : EPOLLOUT;
+                (kind == POLL_IN ? w.polling_in : w.polling_out) = false;
+                // Poll's result may come after watching has been stopped; then it is dropped.
+                if (cqe.res > 0 && (w.flags & direction)) {
+                    mark_ready(fd, direction |
+                                   (static_cast<flags_t>(cqe.res) & (EPOLLERR | EPOLLHUP)));
+                }
+                break;
+            }
+            case TIMER_READ:
+                if (cqe.res == sizeof(timer_value)) {
+                    expirations += timer_value;
+                    mark_ready(timerfd, EPOLLIN);
+                }
+                arm_timer_read();
+                break;
+            case RECV:
+                if (cqe.res >= 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+                    assert(received_num < RECV_BUFFERS);
+                    received[(received_beg + received_num) % RECV_BUFFERS] = Received{
+                            static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT),
+                            static_cast<uint32_t>(cqe.res)};
+                    ++received_num;
+                } else if (cqe.res == -EBADF || cqe.res == -ENOTSOCK || cqe.res == -EFAULT ||
+                           cqe.res == -EINVAL) {
+                    syserr(-cqe.res, "recvmsg (io_uring)");
+                }
+                // Multishot request ends when it runs out of buffers or fails, e.g. with
+                // ECONNREFUSED reported by ICMP; it is then re-armed by wait(),
+                // after receive() gives buffers back.
+                if (!(cqe.flags & IORING_CQE_F_MORE))
+                    receiving = false;
+                break;
+            case PROVIDE_BUFFERS:
+                // Only failures are reported.
+                syserr(-cqe.res, "provide buffers (io_uring)");
+                break;
+            case SEND:
+                assert(sends_in_flight > 0 && value < sends_submitted);
+                send_results[value] = cqe.res;
+                if (--sends_in_flight == 0)
+                    sends_completed();
+                break;
+        }
+    }
+
+    void IoUring::sends_completed() {
+        // Messages are dequeued up to the first failed one, which is retried along with
+        // all further ones. As they are linked, those have been cancelled (-ECANCELED)
+        // without being sent, so none of them gets duplicated.
+        size_t sent = 0;
+        while (sent < sends_submitted && send_results[sent] >= 0)
+            ++sent;
+        sender->complete(*send_queue, sent);
+        bool clogged = false;
+        if (sent < sends_submitted) {
+            int const err = -send_results[sent];
+            clogged = err == EAGAIN;
+            if (!clogged && !sender->fallback(err))
+                syserr(err, "cannot send to remote host (UDP)");
+        }
+        sends_submitted = 0;
+        // Sending is resumed once the socket can take more, not right away,
+        // which would just fail again.
+        if (clogged)
+            arm_poll(sender->socket(), POLL_OUT);
+        else
+            send_completed = true;
+    }
+
+    ReadySet IoUring::wait() {
+        ready.clear();
+
+        for (size_t fd = 0; fd < watching.size(); ++fd) {
+            auto const& w = watching[fd];
+            if (!w.added || w.by_completion)
+                continue;
+            if ((w.flags & EPOLLIN) && !w.polling_in)
+                arm_poll(static_cast<int>(fd), POLL_IN);
+            // Output readiness of the sender's socket is reported by completion of its sends.
+            bool const sending = sends_in_flight > 0 && static_cast<int>(fd) == sender->socket();
+            if ((w.flags & EPOLLOUT) && !w.polling_out && !sending)
+                arm_poll(static_cast<int>(fd), POLL_OUT);
+        }
+
+        if (recv_sock != -1 && !receiving && received_num < RECV_BUFFERS)
+            arm_receiving();
+
+        bool const pending = received_num > 0 || (send_completed && sender != nullptr &&
+                                                  (watched(sender->socket()).flags & EPOLLOUT));
+        enter(pending ? 0 : 1);
+
+        unsigned head = *cq_head;
+        unsigned const tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            handle_completion(cqes[head & cq_mask]);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+        if (received_num > 0)
+            mark_ready(recv_sock, EPOLLIN);
+        if (send_completed && (watched(sender->socket()).flags & EPOLLOUT)) {
+            send_completed = false;
+            mark_ready(sender->socket(), EPOLLOUT);
+        }
+
+        for (size_t i = 1; i < ready.size(); ++i) {
+            if (ready[i].data.fd == timerfd) {
+                std::swap(ready[0], ready[i]);
+                break;
+            }
+        }
+        return ReadySet{ready.data(), ready.data() + ready.size()};
+    }
+
+    uint64_t IoUring::timer_expirations() {
+        uint64_t const res = expirations;
+        expirations = 0;
+        return res;
+    }
+
+    size_t IoUring::receive(UDPReceiveRing& ring) {
+        assert(ring.socket() == recv_sock);
+        size_t const num = std::min(received_num, ring.capacity());
+        for (size_t i = 0; i < num; ++i) {
+            auto const& datagram = received[received_beg];
+            char const *buff = recv_buffers.data() + datagram.buffer_id * RECV_BUFFER_SIZE;
+            auto const *out = reinterpret_cast<io_uring_recvmsg_out const *>(buff);
+            char const *name = buff + sizeof(io_uring_recvmsg_out);
+            char const *payload = name + recv_msg.msg_namelen + recv_msg.msg_controllen;
+            size_t const len = std::min(static_cast<size_t>(out->payloadlen),
+                                        datagram.len - static_cast<size_t>(payload - buff));
+            sockaddr_in6 sender_address{};
+            memcpy(&sender_address, name, std::min(static_cast<size_t>(out->namelen),
+                                                   sizeof(sender_address)));
+            ring.store(i, sender_address, payload, len);
+
+            provide_buffers(datagram.buffer_id, 1);
+            received_beg = (received_beg + 1) % RECV_BUFFERS;
+            --received_num;
+        }
+        return num;
+    }
+
+    bool IoUring::send(UDPBatchSender& batch_sender, SendQueue& queue) {
+        assert(sender == nullptr || sender == &batch_sender);
+        if (sends_in_flight > 0 || watched(batch_sender.socket()).polling_out)
+            return false; // the previous batch has not been completed yet, or clogged up
+        send_completed = false;
+        if (queue.empty())
+            return true;
+
+        sender = &batch_sender;
+        send_queue = &queue;
+        sends_submitted = sender->prepare(queue);
+        // Requests are linked, so that they are performed in order, as sendmmsg would;
+        // a chain cannot be split between submissions, so it has to fit in at once.
+        if (sq_entries - (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE))
+            < sends_submitted)
+            enter(0);
+        for (size_t i = 0; i < sends_submitted; ++i) {
+            io_uring_sqe& sqe = next_sqe();
+            sqe.opcode = IORING_OP_SENDMSG;
+            sqe.fd = sender->socket();
+            sqe.addr = reinterpret_cast<uint64_t>(&sender->messages()[i].msg_hdr);
+            sqe.len = 1;
+            if (i + 1 < sends_submitted)
+                sqe.flags = IOSQE_IO_LINK;
+            sqe.user_data = encode(SEND, static_cast<uint32_t>(i));
+        }
+        sends_in_flight = sends_submitted;
+        ++sender->syscalls;
+        enter(0);
+        return false;
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef ROBAKI_IOURING_H
+#define ROBAKI_IOURING_H
+
+#include <linux/io_uring.h>
+
+#include <array>
+#include <vector>
+
+#include "Reactor.h"
+
+namespace Worms {
+    /* Reactor built on io_uring, driven with raw system calls.
+     * Readiness of ordinary descriptors is reported through one-shot polls re-armed after
+     * each report, so it behaves just like a level-triggered Epoll. Heartbeats, however,
+     * arrive through a multishot recvmsg into provided buffers, queued datagrams
+     * are submitted as batches of linked sendmsg requests and the timer is read
+     * asynchronously. Once sending clogs up, the socket is polled for output. */
+    class IoUring : public Reactor {
+    private:
+        using flags_t = uint32_t;
+
+        static constexpr unsigned const SQ_ENTRIES = 256;
+        static constexpr unsigned const CQ_ENTRIES = 4096;
+        static constexpr unsigned const RECV_BUFFERS = 256; // must be a power of 2
+        static constexpr uint16_t const RECV_BUFFER_GROUP = 0;
+        static constexpr size_t const RECV_BUFFER_SIZE =
+                sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in6) + MAX_DATA_SIZE;
+
+        /* Kind of request, kept in the upper half of its user_data. */
+        enum Request : uint32_t {
+            POLL_IN,
+            POLL_OUT,
+            TIMER_READ,
+            RECV,
+            PROVIDE_BUFFERS,
+            SEND,
+        };
+
+        /* Per-fd bookkeeping, indexed directly by fd. */
+        struct Watched {
+            bool added = false;
+            bool by_completion = false; // input is read by requests of its own instead of polls
+            bool polling_in = false;
+            bool polling_out = false;
+            flags_t flags = 0;
+        };
+
+        /* Datagram received into a provided buffer, awaiting receive(). */
+        struct Received {
+            uint16_t buffer_id;
+            uint32_t len;
+        };
+
+        int ring_fd;
+        int const timerfd;
+
+        // Submission and completion queues, shared with the kernel.
+        void *sq_ptr = nullptr;
+        void *cq_ptr = nullptr;
+        size_t sq_ptr_size = 0;
+        size_t cq_ptr_size = 0;
+        io_uring_sqe *sqes = nullptr;
+        size_t sqes_size = 0;
+        unsigned *sq_head = nullptr;
+        unsigned *sq_tail = nullptr;
+        unsigned *sq_array = nullptr;
+        unsigned sq_mask = 0;
+        unsigned sq_entries = 0;
+        unsigned sq_local_tail = 0;
+        unsigned *cq_head = nullptr;
+        unsigned *cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe *cqes = nullptr;
+
+        std::vector<Watched> watching;
+        std::vector<struct epoll_event> ready;
+
+        uint64_t timer_value = 0;
+        uint64_t expirations = 0;
+
+        int recv_sock = -1;
+        bool receiving = false;
+        msghdr recv_msg{};
+        std::vector<char> recv_buffers;
+        std::array<Received, RECV_BUFFERS> received{};
+        size_t received_beg = 0;
+        size_t received_num = 0;
+
+        UDPBatchSender *sender = nullptr;
+        SendQueue *send_queue = nullptr;
+        size_t sends_in_flight = 0;
+        size_t sends_submitted = 0;
+        std::array<int, UDPBatchSender::BATCH> send_results{};
+        bool send_completed = false;
+
+    public:
+        explicit IoUring(int timerfd);
+
+        ~IoUring() override;
+
+        void add_fd(int fd) override;
+
+        void watch_fd_for_input(int fd) override;
+
+        void stop_watching_fd_for_input(int fd) override;
+
+        void watch_fd_for_output(int fd) override;
+
+        void stop_watching_fd_for_output(int fd) override;
+
+        void watch_for_datagrams(UDPReceiveRing& ring) override;
+
+        ReadySet wait() override;
+
+        uint64_t timer_expirations() override;
+
+        size_t receive(UDPReceiveRing& ring) override;
+
+        bool send(UDPBatchSender& batch_sender, SendQueue& queue) override;
+
+    private:
+        Watched& watched(int fd);
+
+        io_uring_sqe& next_sqe();
+
+        /* Submits prepared requests and waits for at least min_complete completions. */
+        void enter(unsigned min_complete);
+
+        void handle_completion(io_uring_cqe const& cqe);
+
+        void mark_ready(int fd, flags_t events);
+
+        void arm_poll(int fd, Request kind);
+
+        void arm_timer_read();
+
+        void arm_receiving();
+
+        /* Gives consecutive receive buffers (back) to the kernel. */
+        void provide_buffers(uint16_t first_id, uint16_t num);
+
+        void sends_completed();
+    };
+}
+
+#endif //ROBAKI_IOURING_H
@@ -0,0 +1,71 @@
+#ifndef ROBAKI_MULTICAST_H
+#define ROBAKI_MULTICAST_H
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include <optional>
+#include <string>
+
+#include "err.h"
+
+namespace Worms {
+    /* Parses an IPv6 multicast group, optionally followed by %interface, as in
+     * ff02::4242%eth0. An interface is required by link-local groups; otherwise
+     * the kernel chooses one. Returns nothing if the group is invalid. */
+    inline std::optional<sockaddr_in6> parse_multicast_group(std::string const& spec,
+                                                             uint16_t const port) {
+        sockaddr_in6 group{};
+        group.sin6_family = AF_INET6;
+        group.sin6_port = htobe16(port);
+
+        size_t const percent = spec.find('%');
+        if (inet_pton(AF_INET6, spec.substr(0, percent).c_str(), &group.sin6_addr) != 1 ||
+            !IN6_IS_ADDR_MULTICAST(&group.sin6_addr))
+            return {};
+        if (percent != std::string::npos) {
+            group.sin6_scope_id = if_nametoindex(spec.c_str() + percent + 1);
+            if (group.sin6_scope_id == 0)
+                return {};
+        }
+        return group;
+    }
+
+    /* Makes datagrams sent to multicast groups through sock leave by the given interface. */
+    inline void set_multicast_interface(int const sock, unsigned const interface) {
+        verify(setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_IF, &interface, sizeof(interface)),
+               "setsockopt IPV6_MULTICAST_IF");
+    }
+
+    /* Opens a non-blocking UDP socket receiving datagrams sent to the group.
+     * The port may be shared with other receivers of the group on the same host. */
+    inline int open_group_socket(sockaddr_in6 const& group) {
+        int const sock = socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock < 0)
+            syserr(errno, "opening socket");
+
+        int const enable = 1;
+        verify(setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)),
+               "setsockopt SO_REUSEADDR");
+
+        sockaddr_in6 address{};
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_any;
+        address.sin6_port = group.sin6_port;
+        verify(bind(sock, (struct sockaddr *) &address, sizeof(address)), "bind");
+
+        ipv6_mreq membership{};
+        membership.ipv6mr_multiaddr = group.sin6_addr;
+        membership.ipv6mr_interface = group.sin6_scope_id;
+        verify(setsockopt(sock, IPPROTO_IPV6, IPV6_JOIN_GROUP, &membership, sizeof(membership)),
+               "setsockopt IPV6_JOIN_GROUP");
+
+        verify(fcntl(sock, F_SETFL, O_NONBLOCK), "fcntl");
+        return sock;
+    }
+}
+
+#endif //ROBAKI_MULTICAST_H
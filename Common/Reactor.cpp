@@ -0,0 +1,28 @@
+#include "Reactor.h"
+
+#include <cstring>
+
+#include "Epoll.h"
+#include "IoUring.h"
+
+namespace Worms {
+    std::optional<Reactor::Backend> parse_backend(char const *name) {
+        if (strcmp(name, "epoll") == 0)
+            return Reactor::Backend::EPOLL;
+        if (strcmp(name, "io_uring") == 0)
+            return Reactor::Backend::IO_URING;
+        return {};
+    }
+
+    std::unique_ptr<Reactor> make_reactor(Reactor::Backend const backend, int const timerfd,
+                                          bool const edge_triggered) {
+        switch (backend) {
+            case Reactor::Backend::EPOLL:
+                return std::make_unique<Epoll>(timerfd, edge_triggered);
+            case Reactor::Backend::IO_URING:
+                return std::make_unique<IoUring>(timerfd);
+        }
+        assert(false);
+        return nullptr;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef ROBAKI_REACTOR_H
+#define ROBAKI_REACTOR_H
+
+#include <sys/epoll.h>
+
+#include <memory>
+#include <optional>
+
+#include "Buffer.h"
+
+namespace Worms {
+    /* Range of events returned by a single Reactor::wait(). */
+    class ReadySet {
+    private:
+        struct epoll_event const *const _begin;
+        struct epoll_event const *const _end;
+    public:
+        ReadySet(struct epoll_event const *begin, struct epoll_event const *end)
+                : _begin{begin}, _end{end} {}
+
+        [[nodiscard]] struct epoll_event const *begin() const {
+            return _begin;
+        }
+
+        [[nodiscard]] struct epoll_event const *end() const {
+            return _end;
+        }
+    };
+
+    /* Event loop backend driving main loops of both server and client.
+     * Readiness of descriptors is reported epoll-style, while datagram and timer I/O
+     * goes through the reactor too, as completion-based backends perform it on their own. */
+    class Reactor {
+    public:
+        enum class Backend {
+            EPOLL,
+            IO_URING,
+        };
+
+        virtual ~Reactor() = default;
+
+        virtual void add_fd(int fd) = 0;
+
+        virtual void watch_fd_for_input(int fd) = 0;
+
+        virtual void stop_watching_fd_for_input(int fd) = 0;
+
+        virtual void watch_fd_for_output(int fd) = 0;
+
+        virtual void stop_watching_fd_for_output(int fd) = 0;
+
+        /* Starts reporting input readiness of the ring's socket (already added),
+         * after which datagrams are to be fetched with receive(). */
+        virtual void watch_for_datagrams(UDPReceiveRing& ring) = 0;
+
+        /* Waits for events and returns all ready ones at once.
+         * The timer's event, if present, is always the first one,
+         * so that rounds are not delayed by a flood of other events. */
+        virtual ReadySet wait() = 0;
+
+        /* Returns the number of timer expirations since the previous call. */
+        virtual uint64_t timer_expirations() = 0;
+
+        /* Fills consecutive slots of the ring with received datagrams.
+         * Returns the number of filled slots, 0 if there was nothing to receive. */
+        virtual size_t receive(UDPReceiveRing& ring) = 0;
+
+        /* Sends datagrams from the queue, or hands them over to the kernel.
+         * Returns false if some of them are still pending; output readiness
+         * of sender's socket is then reported once sending can be resumed.
+         * Completion-based backends return false after every submission, as it is
+         * pending until it completes; watching the socket for output then costs
+         * no poll, as the completion itself is reported as output readiness. */
+        virtual bool send(UDPBatchSender& sender, SendQueue& queue) = 0;
+    };
+
+    std::optional<Reactor::Backend> parse_backend(char const *name);
+
+    /* Creates a reactor of given backend, with the timer already added.
+     * Edge-triggered mode is only a hint, honoured by backends supporting it. */
+    std::unique_ptr<Reactor> make_reactor(Reactor::Backend backend, int timerfd,
+                                          bool edge_triggered = false);
+}
+
+#endif //ROBAKI_REACTOR_H
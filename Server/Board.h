@@ -2,6 +2,12 @@
 #define ROBAKI_BOARD_H
 
 #include <ctgmath>
+#include <array>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include "../Common/Buffer.h"
 #include "Pixel.h"
@@ -33,8 +39,30 @@ namespace Worms {
             return angle * M_PI / 180.0;
         }
 
+        /* Unit vector pointing at this angle. */
+        [[nodiscard]] std::pair<double, double> const& direction() const;
     };
 
+    namespace detail {
+        /* Unit vectors of all angles, computed once, exactly as they would be every time:
+         * using a table does not change any position, and so any game, in the slightest. */
+        inline std::array<std::pair<double, double>, angle_t::MAX_ANGLE> const& directions() {
+            static auto const table = [] {
+                std::array<std::pair<double, double>, angle_t::MAX_ANGLE> vectors;
+                for (uint16_t i = 0; i < angle_t::MAX_ANGLE; ++i) {
+                    double const radians = angle_t{i}.to_radians();
+                    vectors[i] = {std::cos(radians), std::sin(radians)};
+                }
+                return vectors;
+            }();
+            return table;
+        }
+    }
+
+    inline std::pair<double, double> const& angle_t::direction() const {
+        return detail::directions()[angle];
+    }
+
     class Position {
     private:
         double x;
@@ -43,8 +71,9 @@ namespace Worms {
         Position(double x, double y): x{x}, y{y} {}
 
         void move_with_angle(angle_t angle) {
-            x += std::cos(angle.to_radians());
-            y += std::sin(angle.to_radians());
+            auto const& [dx, dy] = angle.direction();
+            x += dx;
+            y += dy;
         }
 
         [[nodiscard]] Pixel as_pixel() const {
@@ -52,32 +81,273 @@ namespace Worms {
         }
     };
 
-    class Board {
+    /* Layouts of a board's bitmap in 64-bit words, chosen by BasicBoard's parameter. */
+
+    /* Pixel (x, y) is bit x % 64 of the word x / 64 of row y. */
+    class RowMajorLayout {
+    private:
+        size_t const words_per_row;
+        size_t const rows;
+
+    public:
+        RowMajorLayout(uint32_t const width, uint32_t const height)
+                : words_per_row{(width + size_t{63}) / 64}, rows{height} {}
+
+        [[nodiscard]] size_t words() const {
+            return words_per_row * rows;
+        }
+
+        [[nodiscard]] size_t word(Pixel const position) const {
+            return position.y * words_per_row + position.x / 64;
+        }
+
+        [[nodiscard]] static uint64_t bit(Pixel const position) {
+            return uint64_t{1} << (position.x % 64);
+        }
+    };
+
+    /* Each word is an 8x8 tile of pixels, so that a worm turning in any direction
+     * stays within a word for a few rounds, instead of jumping between rows. */
+    class TiledLayout {
     private:
-        std::vector<std::vector<bool>> eaten;
-        GameConstants const& constants;
+        size_t const tiles_per_row;
+        size_t const tile_rows;
 
     public:
-        explicit Board(GameConstants const& constants) : constants(constants) {
-            eaten.resize(constants.width);
-            for (auto &vec: eaten) {
-                vec.resize(constants.height);
+        TiledLayout(uint32_t const width, uint32_t const height)
+                : tiles_per_row{(width + size_t{7}) / 8}, tile_rows{(height + size_t{7}) / 8} {}
+
+        [[nodiscard]] size_t words() const {
+            return tiles_per_row * tile_rows;
+        }
+
+        [[nodiscard]] size_t word(Pixel const position) const {
+            return position.y / 8 * tiles_per_row + position.x / 8;
+        }
+
+        [[nodiscard]] static uint64_t bit(Pixel const position) {
+            return uint64_t{1} << (position.y % 8 * 8 + position.x % 8);
+        }
+    };
+
+    /* Bitmap of eaten pixels, in a single allocation laid out by Layout.
+     * It is meant to be reused by consecutive games: words touched are remembered,
+     * so clearing costs as much as the previous game has eaten, not the whole board. */
+    template<typename Layout>
+    class BasicBoard {
+    private:
+        uint32_t const width;
+        uint32_t const height;
+        Layout const layout;
+        std::vector<uint64_t> eaten;
+        std::vector<size_t> touched_words;
+
+    public:
+        explicit BasicBoard(GameConstants const& constants)
+                : width{constants.width}, height{constants.height},
+                  layout{constants.width, constants.height}, eaten(layout.words(), 0) {}
+
+        [[nodiscard]] bool contains(Pixel const position) const {
+            return position.on_board(width, height);
+        }
+
+        [[nodiscard]] bool is_eaten(Pixel const position) const {
+            assert(contains(position));
+            return eaten[layout.word(position)] & layout.bit(position);
+        }
+
+        void eat(Pixel const position) {
+            assert(contains(position));
+            assert(!is_eaten(position));
+            uint64_t& word = eaten[layout.word(position)];
+            if (word == 0)
+                touched_words.push_back(layout.word(position));
+            word |= layout.bit(position);
+        }
+
+        /* Eats the pixel unless it is off the board or eaten already.
+         * Returns whether it did, i.e. whether a worm entering it survives. */
+        bool try_eat(Pixel const position) {
+            if (!contains(position))
+                return false;
+            size_t const index = layout.word(position);
+            uint64_t const bit = layout.bit(position);
+            if (eaten[index] & bit)
+                return false;
+            if (eaten[index] == 0)
+                touched_words.push_back(index);
+            eaten[index] |= bit;
+            return true;
+        }
+
+        void clear() {
+            for (size_t const word : touched_words) {
+                eaten[word] = 0;
             }
+            touched_words.clear();
+        }
+    };
+
+    /* Bitmap of eaten pixels made of square tiles, allocated only once a pixel of theirs
+     * gets eaten, so memory is proportional to the area touched, not to the whole board.
+     * Tiles are found through a hash directory, in front of which a small cache holds
+     * recently used ones; a worm stays within a tile for dozens of rounds.
+     * Like BasicBoard, it is reused by consecutive games, tiles included. */
+    class SparseBoard {
+    private:
+        // A tile is a row-major 64x64 bitmap, a word per row.
+        static constexpr uint32_t const TILE_SIDE = 64;
+        static constexpr size_t const CACHE_SIZE = 8;
+        static constexpr uint64_t const NO_TILE = UINT64_MAX;
+
+        struct Tile {
+            std::array<uint64_t, TILE_SIDE> rows;
+        };
+
+        struct CacheEntry {
+            uint64_t key = NO_TILE;
+            Tile* tile = nullptr;
+        };
+
+        uint32_t const width;
+        uint32_t const height;
+        std::unordered_map<uint64_t, Tile*> directory;
+        // Tiles never move, as a deque does not move its elements when growing.
+        std::deque<Tile> tiles;
+        size_t tiles_used = 0;
+        std::array<CacheEntry, CACHE_SIZE> mutable cache;
+
+        [[nodiscard]] static uint64_t key_of(Pixel const position) {
+            return uint64_t{position.y / TILE_SIDE} << 32 | position.x / TILE_SIDE;
+        }
+
+        [[nodiscard]] static uint64_t bit(Pixel const position) {
+            return uint64_t{1} << (position.x % TILE_SIDE);
+        }
+
+        [[nodiscard]] CacheEntry& cached(uint64_t const key) const {
+            return cache[(key ^ key >> 29) % CACHE_SIZE];
+        }
+
+        [[nodiscard]] Tile* find(uint64_t const key) const {
+            CacheEntry& entry = cached(key);
+            if (entry.key == key)
+                return entry.tile;
+            auto const it = directory.find(key);
+            if (it == directory.end())
+                return nullptr;
+            entry = CacheEntry{key, it->second};
+            return it->second;
+        }
+
+        Tile* allocate(uint64_t const key) {
+            if (tiles_used == tiles.size())
+                tiles.emplace_back();
+            Tile* const tile = &tiles[tiles_used++];
+            tile->rows.fill(0);
+            directory.emplace(key, tile);
+            cached(key) = CacheEntry{key, tile};
+            return tile;
         }
 
+    public:
+        explicit SparseBoard(GameConstants const& constants)
+                : width{constants.width}, height{constants.height} {}
+
         [[nodiscard]] bool contains(Pixel const position) const {
-            return position.on_board(constants.width, constants.height);
+            return position.on_board(width, height);
         }
 
         [[nodiscard]] bool is_eaten(Pixel const position) const {
             assert(contains(position));
-            return eaten[position.x][position.y];
+            Tile const* const tile = find(key_of(position));
+            return tile != nullptr && (tile->rows[position.y % TILE_SIDE] & bit(position));
         }
 
         void eat(Pixel const position) {
             assert(contains(position));
-            assert(!eaten[position.x][position.y]);
-            eaten[position.x][position.y] = true;
+            assert(!is_eaten(position));
+            uint64_t const key = key_of(position);
+            Tile* tile = find(key);
+            if (tile == nullptr)
+                tile = allocate(key);
+            tile->rows[position.y % TILE_SIDE] |= bit(position);
+        }
+
+        /* Like BasicBoard::try_eat(). */
+        bool try_eat(Pixel const position) {
+            if (!contains(position))
+                return false;
+            uint64_t const key = key_of(position);
+            Tile* tile = find(key);
+            if (tile == nullptr)
+                tile = allocate(key);
+            else if (tile->rows[position.y % TILE_SIDE] & bit(position))
+                return false;
+            tile->rows[position.y % TILE_SIDE] |= bit(position);
+            return true;
+        }
+
+        void clear() {
+            directory.clear();
+            tiles_used = 0;
+            cache.fill(CacheEntry{});
+        }
+    };
+
+    /* Board of a game: a single bitmap, unless the board is so large
+     * that only the sparse one can afford it. The bitmap is tiled: it is as fast
+     * as a row-major one on small boards and faster from 1920x1080 up, as a worm
+     * touches fewer cache lines (see bench/board_layouts.cpp). */
+    class Board {
+    private:
+        // 8 MiB of bitmap, e.g. 8192x8192 pixels.
+        static constexpr size_t const DENSE_LIMIT_WORDS = size_t{1} << 20;
+
+        using DenseBoard = BasicBoard<TiledLayout>;
+
+        std::variant<DenseBoard, SparseBoard> board;
+
+        static std::variant<DenseBoard, SparseBoard> make(GameConstants const& constants) {
+            if (TiledLayout{constants.width, constants.height}.words() <= DENSE_LIMIT_WORDS)
+                return std::variant<DenseBoard, SparseBoard>{std::in_place_type<DenseBoard>,
+                                                             constants};
+            return std::variant<DenseBoard, SparseBoard>{std::in_place_type<SparseBoard>,
+                                                         constants};
+        }
+
+    public:
+        explicit Board(GameConstants const& constants) : board{make(constants)} {}
+
+        [[nodiscard]] bool contains(Pixel const position) const {
+            if (auto const* dense = std::get_if<DenseBoard>(&board))
+                return dense->contains(position);
+            return std::get<SparseBoard>(board).contains(position);
+        }
+
+        [[nodiscard]] bool is_eaten(Pixel const position) const {
+            if (auto const* dense = std::get_if<DenseBoard>(&board))
+                return dense->is_eaten(position);
+            return std::get<SparseBoard>(board).is_eaten(position);
+        }
+
+        void eat(Pixel const position) {
+            if (auto* dense = std::get_if<DenseBoard>(&board))
+                return dense->eat(position);
+            std::get<SparseBoard>(board).eat(position);
+        }
+
+        /* Dispatched once, where checking and eating separately would take three. */
+        bool try_eat(Pixel const position) {
+            if (auto* dense = std::get_if<DenseBoard>(&board))
+                return dense->try_eat(position);
+            return std::get<SparseBoard>(board).try_eat(position);
+        }
+
+        void clear() {
+            if (auto* dense = std::get_if<DenseBoard>(&board))
+                return dense->clear();
+            std::get<SparseBoard>(board).clear();
         }
     };
 }
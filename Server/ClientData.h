@@ -1,60 +1,93 @@
 #ifndef ROBAKI_CLIENTDATA_H
 #define ROBAKI_CLIENTDATA_H
 
+#include <cstdint>
 #include <cstring>
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <optional>
+
+#include "Player.h"
+#include "SlotMap.h"
+
 namespace Worms {
-    class Player;
 
-    struct ClientData {
-        struct Comparator {
-            using is_transparent = void;
+    /* Token bucket limiting datagrams queued for a single client catching up with a game.
+     * It refills lazily, by a fixed number of datagrams for every round passed. */
+    class SendBudget {
+    private:
+        static constexpr uint64_t const DATAGRAMS_PER_ROUND = 4;
+        static constexpr uint64_t const BURST = 64;
 
-            bool operator()(sockaddr_in6 const& addr1, sockaddr_in6 const& addr2) const {
-                return memcmp(&addr1, &addr2, sizeof(sockaddr_in6)) < 0;
-            }
+        uint64_t tokens = BURST;
+        uint64_t refilled_round_no;
 
-            bool operator()(ClientData const &c1, ClientData const &c2) const {
-                return operator()(c1.address, c2.address);
-            }
+    public:
+        explicit SendBudget(uint64_t const round_no) : refilled_round_no{round_no} {}
 
-            bool operator()(sockaddr_in6 const &addr, ClientData const& c) const {
-                return operator()(addr, c.address);
-            }
+        void refill(uint64_t const round_no) {
+            tokens = std::min(BURST, tokens + (round_no - refilled_round_no) * DATAGRAMS_PER_ROUND);
+            refilled_round_no = round_no;
+        }
 
-            bool operator()(ClientData const& c, sockaddr_in6 const &addr) const {
-                return operator()(c.address, addr);
-            }
+        bool try_spend() {
+            if (tokens == 0)
+                return false;
+            --tokens;
+            return true;
+        }
+    };
 
-            bool operator()(std::shared_ptr<ClientData> const &c1,
-                    std::shared_ptr<ClientData> const &c2) const {
-                return operator()(*c1, *c2);
-            }
+    /* Client's address, normalized for lookups: flow info is not part of it. */
+    struct Endpoint {
+        in6_addr address;
+        uint16_t port;
+        uint32_t scope_id;
 
-            bool operator()(sockaddr_in6 const &addr, std::shared_ptr<ClientData> const& c) const {
-                return operator()(addr, c->address);
-            }
+        static Endpoint of(sockaddr_in6 const& addr) {
+            return Endpoint{addr.sin6_addr, addr.sin6_port, addr.sin6_scope_id};
+        }
 
-            bool operator()(std::shared_ptr<ClientData> const& c, sockaddr_in6 const &addr) const {
-                return operator()(c->address, addr);
+        bool operator==(Endpoint const& other) const {
+            return memcmp(&address, &other.address, sizeof(address)) == 0 &&
+                   port == other.port && scope_id == other.scope_id;
+        }
+
+        struct Hash {
+            size_t operator()(Endpoint const& endpoint) const {
+                uint64_t halves[2];
+                memcpy(halves, &endpoint.address, sizeof(halves));
+                return halves[0] ^ (halves[1] * 31 + endpoint.port) ^
+                       static_cast<uint64_t>(endpoint.scope_id) << 32;
             }
         };
+    };
 
-        sockaddr_in6 const address;
-        uint64_t const session_id;
-        uint64_t mutable last_heartbeat_round_no;
-        Player& player;
+    /* Client connected to a room, kept in the room's SlotMap along with its player.
+     * Members are not const, so that clients can be moved around within it. */
+    struct ClientData {
+        sockaddr_in6 address;
+        uint64_t session_id;
+        uint64_t last_heartbeat_round_no;
+        Player player;
+        SendBudget budget;
+        // Event from which the client still awaits its catch-up, deferred for lack of budget.
+        std::optional<uint32_t> pending_catch_up;
 
         ClientData(sockaddr_in6 const &address, uint64_t const session_id,
-                   uint64_t last_heartbeat_round_no, Player &player)
+                   uint64_t last_heartbeat_round_no, Player player)
                    : address{address}, session_id{session_id},
-                     last_heartbeat_round_no{last_heartbeat_round_no}, player{player} {}
+                     last_heartbeat_round_no{last_heartbeat_round_no}, player{std::move(player)},
+                     budget{last_heartbeat_round_no} {}
 
         void heart_has_beaten(uint64_t round_no) {
             last_heartbeat_round_no = round_no;
         }
     };
+
+    using ClientSlots = SlotMap<ClientData>;
+    using ClientHandle = ClientSlots::Handle;
 }
 
 #endif //ROBAKI_CLIENTDATA_H
@@ -0,0 +1,66 @@
+#include "EventLog.h"
+
+namespace Worms {
+    EventLog::EventLog(uint32_t const game_id, std::pmr::memory_resource* const memory)
+            : game_id{game_id}, chunks{memory}, index{memory} {
+        new_chunk();
+    }
+
+    void EventLog::new_chunk() {
+        auto chunk = std::make_shared<Chunk>();
+        uint32_t const header = htobe(game_id);
+        memcpy(chunk->bytes, &header, sizeof(header));
+        chunk->used = sizeof(header);
+        chunks.push_back(std::move(chunk));
+    }
+
+    void EventLog::store() {
+        if (CHUNK_SIZE - chunks.back()->used < staging.size())
+            new_chunk();
+
+        auto& chunk = *chunks.back();
+        memcpy(chunk.bytes + chunk.used, staging.data(), staging.size());
+        index.push_back(Location{static_cast<uint32_t>(chunks.size() - 1),
+                                 static_cast<uint32_t>(chunk.used),
+                                 static_cast<uint32_t>(chunk.used + staging.size())});
+        chunk.used += staging.size();
+        assert(intact(index.back()));
+    }
+
+    bool EventLog::intact(Location const& location) const {
+        // Record: len, then len bytes covered by the crc32 following them.
+        char const* const record = chunks[location.chunk]->bytes + location.begin;
+        uint32_t len;
+        uint32_t crc32;
+        memcpy(&len, record, sizeof(len));
+        len = betoh(len);
+        if (location.end - location.begin != sizeof(len) + len + sizeof(crc32))
+            return false;
+        memcpy(&crc32, record + sizeof(len) + len, sizeof(crc32));
+        return betoh(crc32) == Crc32Computer::compute_in_buffer(record, sizeof(len) + len);
+    }
+
+    void EventLog::dump(std::string& out) const {
+        out.append(chunks.front()->bytes, sizeof(game_id));
+        for (auto const& chunk : chunks) {
+            out.append(chunk->bytes + sizeof(game_id), chunk->used - sizeof(game_id));
+        }
+    }
+
+    QueuedDatagram EventLog::datagram(size_t const first, size_t& end,
+                                      sockaddr_in6 const& receiver, bool const live) const {
+        assert(first < index.size());
+        auto const& begin = index[first];
+        size_t const limit = begin.begin + MAX_DATA_SIZE - sizeof(game_id);
+        end = first + 1;
+        while (end < index.size() && index[end].chunk == begin.chunk && index[end].end <= limit)
+            ++end;
+
+        auto const& chunk = chunks[begin.chunk];
+        return QueuedDatagram{receiver, chunk,
+                              chunk->bytes, sizeof(game_id),
+                              chunk->bytes + begin.begin,
+                              static_cast<uint16_t>(index[end - 1].end - begin.begin),
+                              live};
+    }
+}
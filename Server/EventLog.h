@@ -0,0 +1,79 @@
+#ifndef ROBAKI_EVENTLOG_H
+#define ROBAKI_EVENTLOG_H
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../Common/Buffer.h"
+#include "../Common/Event.h"
+
+namespace Worms {
+    /* Events of a single game, stored in wire format in append-only chunks of memory.
+     * Every event is encoded, checksum included, exactly once: when it is appended.
+     * Every chunk starts with the game_id, so that a datagram is made of that header and
+     * a single slice of consecutive events, both borrowed from the same chunk.
+     * An event never spans two chunks, so neither does a datagram. Chunks are shared
+     * with enqueued datagrams, which keep them alive even after the game is gone. */
+    class EventLog {
+    private:
+        static constexpr size_t const CHUNK_SIZE = 64 * 1024;
+
+        struct Chunk {
+            char bytes[CHUNK_SIZE];
+            size_t used;
+        };
+
+        /* Where an event is, in chunk's bytes [begin, end). */
+        struct Location {
+            uint32_t chunk;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        uint32_t const game_id;
+        std::pmr::vector<std::shared_ptr<Chunk>> chunks;
+        std::pmr::vector<Location> index;
+        UDPSendBuffer staging;
+
+        void new_chunk();
+
+        /* Moves the event packed into staging to the log. */
+        void store();
+
+        /* Checks the stored record against its length and checksum, for debugging. */
+        [[nodiscard]] bool intact(Location const& location) const;
+
+    public:
+        /* The index lives in memory (of the game), whereas chunks are allocated
+         * on their own, as datagrams may keep them after the game is gone. */
+        EventLog(uint32_t game_id, std::pmr::memory_resource* memory);
+
+        /* Number of events in the log. */
+        [[nodiscard]] size_t size() const {
+            return index.size();
+        }
+
+        /* Appends the next event, packed without any virtual call or allocation
+         * (apart from those of the log's own growth). */
+        template<typename EventData>
+        void append(uint8_t const event_type, EventData data) {
+            EventImpl<EventData> const event{static_cast<uint32_t>(index.size()), event_type,
+                                             std::move(data)};
+            staging.clear();
+            event.pack(staging);
+            store();
+        }
+
+        /* Appends the game_id and all events, in wire format, to out. */
+        void dump(std::string& out) const;
+
+        /* Builds a datagram to receiver carrying events from first on, as many as fit
+         * (but at least one). Sets end to the number of the first event left out. */
+        QueuedDatagram datagram(size_t first, size_t& end, sockaddr_in6 const& receiver,
+                                bool live) const;
+    };
+}
+
+#endif //ROBAKI_EVENTLOG_H
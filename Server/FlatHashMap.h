@@ -0,0 +1,188 @@
+#ifndef ROBAKI_FLATHASHMAP_H
+#define ROBAKI_FLATHASHMAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Worms {
+    /* Hash map with open addressing and linear probing over a single array of slots,
+     * so that a lookup usually touches one or two cache lines, however many entries
+     * there are. It is kept at most half full; erasing shifts back the entries
+     * that follow, so there are no tombstones. Hashes are spread with Fibonacci
+     * hashing, so Hash need not mix its bits well.
+     * Keys must not be modified through iterators; any insertion or erasure
+     * invalidates all iterators and pointers to values. */
+    template<typename Key, typename Value, typename Hash = std::hash<Key>>
+    class FlatHashMap {
+    private:
+        static constexpr size_t const MIN_CAPACITY = 16;
+
+        struct Slot {
+            std::pair<Key, Value> entry;
+            bool used = false;
+        };
+
+        std::vector<Slot> slots;
+        size_t count = 0;
+        unsigned shift;
+
+        [[nodiscard]] size_t home(Key const& key) const {
+            return static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull >> shift;
+        }
+
+        [[nodiscard]] size_t next(size_t const i) const {
+            return (i + 1) & (slots.size() - 1);
+        }
+
+        /* Slot holding key, or the empty one where it would be inserted. */
+        [[nodiscard]] size_t probe(Key const& key) const {
+            size_t i = home(key);
+            while (slots[i].used && !(slots[i].entry.first == key)) {
+                i = next(i);
+            }
+            return i;
+        }
+
+        void rehash(size_t const capacity) {
+            std::vector<Slot> old = std::move(slots);
+            slots = std::vector<Slot>(capacity);
+            shift = 64;
+            for (size_t c = capacity; c > 1; c >>= 1) {
+                --shift;
+            }
+            for (auto& slot : old) {
+                if (slot.used) {
+                    Slot& target = slots[probe(slot.entry.first)];
+                    target.entry = std::move(slot.entry);
+                    target.used = true;
+                }
+            }
+        }
+
+    public:
+        template<typename Entry, typename Slots>
+        class Iterator {
+        private:
+            Slots* slots;
+            size_t i;
+
+            void skip_empty() {
+                while (i < slots->size() && !(*slots)[i].used) {
+                    ++i;
+                }
+            }
+
+        public:
+            Iterator(Slots* slots, size_t const i) : slots{slots}, i{i} {
+                skip_empty();
+            }
+
+            Entry& operator*() const {
+                return (*slots)[i].entry;
+            }
+
+            Entry* operator->() const {
+                return &(*slots)[i].entry;
+            }
+
+            Iterator& operator++() {
+                ++i;
+                skip_empty();
+                return *this;
+            }
+
+            bool operator!=(Iterator const& other) const {
+                return i != other.i;
+            }
+        };
+
+        using iterator = Iterator<std::pair<Key, Value>, std::vector<Slot>>;
+        using const_iterator = Iterator<std::pair<Key, Value> const, std::vector<Slot> const>;
+
+        FlatHashMap() {
+            rehash(MIN_CAPACITY);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+
+        /* Returns the value of key, or nullptr if there is none. */
+        [[nodiscard]] Value* find(Key const& key) {
+            Slot& slot = slots[probe(key)];
+            return slot.used ? &slot.entry.second : nullptr;
+        }
+
+        [[nodiscard]] Value const* find(Key const& key) const {
+            Slot const& slot = slots[probe(key)];
+            return slot.used ? &slot.entry.second : nullptr;
+        }
+
+        [[nodiscard]] bool contains(Key const& key) const {
+            return slots[probe(key)].used;
+        }
+
+        /* Returns the value of key, inserting the given one if there was none. */
+        Value& insert(Key key, Value value) {
+            if (2 * (count + 1) > slots.size())
+                rehash(2 * slots.size());
+            Slot& slot = slots[probe(key)];
+            if (!slot.used) {
+                slot.entry = {std::move(key), std::move(value)};
+                slot.used = true;
+                ++count;
+            }
+            return slot.entry.second;
+        }
+
+        /* Returns false if there was no such key. */
+        bool erase(Key const& key) {
+            size_t hole = probe(key);
+            if (!slots[hole].used)
+                return false;
+            slots[hole] = Slot{};
+            --count;
+
+            // Entries probed past the hole move back into it, unless they would
+            // move before their home slot; the run ends at the first empty slot.
+            for (size_t i = next(hole); slots[i].used; i = next(i)) {
+                size_t const wanted = home(slots[i].entry.first);
+                bool const hole_between = hole <= i ? (wanted <= hole || wanted > i)
+                                                    : (wanted <= hole && wanted > i);
+                if (hole_between) {
+                    slots[hole] = std::move(slots[i]);
+                    slots[i] = Slot{};
+                    hole = i;
+                }
+            }
+            return true;
+        }
+
+        iterator begin() {
+            return iterator{&slots, 0};
+        }
+
+        iterator end() {
+            return iterator{&slots, slots.size()};
+        }
+
+        const_iterator begin() const {
+            return const_iterator{&slots, 0};
+        }
+
+        const_iterator end() const {
+            return const_iterator{&slots, slots.size()};
+        }
+    };
+}
+
+#endif //ROBAKI_FLATHASHMAP_H
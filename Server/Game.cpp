@@ -2,164 +2,130 @@
 
 namespace Worms {
 
-    Game::Game(GameConstants const &constants, RandomGenerator &rand,
-               std::set<std::shared_ptr<Player>, Player::Comparator> const &ready_players,
-               std::vector<std::weak_ptr<Player>> observers)
-            : constants{constants}, board{constants}, game_id{rand()},
-              alive_players_num{ready_players.size()}, observers{std::move(observers)} {
-        for (auto& player: ready_players) {
-            player->new_game();
-            players.push_back(player);
+    Game::Game(GameConstants const &constants, Board& board, GameArena& arena,
+               RandomGenerator &rand, ClientSlots& clients)
+            : constants{constants}, board{board}, _arena{arena}, game_id{rand()},
+              event_log{game_id, arena.resource()}, clients{clients},
+              worms{arena.resource()} {
+        board.clear();
+        for (size_t i = 0; i < clients.size(); ++i) {
+            Player& player = clients[i].player;
+            if (player.is_observer())
+                continue;
+            player.new_game();
+            worms.push_back(Worm{clients.handle_at(i), player.turn_direction, true, {}, 0});
         }
+        alive_players_num = worms.size();
 
         // Sort players alphabetically.
-        std::sort(players.begin(), players.end(),
-                  [](std::shared_ptr<Player> const& p1,
-                     std::shared_ptr<Player> const& p2){
-                      return p1->player_name < p2->player_name;
+        std::sort(worms.begin(), worms.end(),
+                  [&clients](Worm const& w1, Worm const& w2){
+                      return clients.get(w1.client)->player.player_name <
+                             clients.get(w2.client)->player.player_name;
                   });
 
         {   // Generate NEW_GAME.
             std::vector<std::string> player_names;
-            player_names.resize(players.size());
-            for (size_t i = 0; i < players.size(); ++i) {
-                player_names[i] = players[i]->player_name;
+            player_names.resize(worms.size());
+            for (size_t i = 0; i < worms.size(); ++i) {
+                player_names[i] = clients.get(worms[i].client)->player.player_name;
             }
-            generate_event(NEW_GAME_NUM, std::make_unique<Data_NEW_GAME>(
-                    constants.width, constants.height, std::move(player_names)));
+            emit_new_game(std::move(player_names));
         }
 
         // Place players at initial positions.
-        for (size_t i = 0; i < players.size(); ++i) {
-            auto& player = players[i];
+        for (size_t i = 0; i < worms.size(); ++i) {
+            auto& worm = worms[i];
             auto x_pos = rand() % constants.width + 0.5;
             auto y_pos = rand() % constants.height + 0.5;
-            player->position.emplace(x_pos, y_pos);
-            player->angle = rand() % 360;
-            auto player_pixel = player->position->as_pixel();
-            if (!board.contains(player_pixel) || board.is_eaten(player_pixel)) {
-                generate_event(PLAYER_ELIMINATED_NUM,
-                               std::make_unique<Data_PLAYER_ELIMINATED>(i));
-            } else {
-                board.eat(player_pixel);
-                generate_event(PIXEL_NUM,std::make_unique<Data_PIXEL>(
-                        i, player_pixel.x, player_pixel.y));
-            }
+            worm.position.emplace(x_pos, y_pos);
+            worm.angle = rand() % 360;
+            auto player_pixel = worm.position->as_pixel();
+            if (board.try_eat(player_pixel))
+                emit_pixel(i, player_pixel.x, player_pixel.y);
+            else
+                emit_player_eliminated(i);
         }
     }
 
     void Game::play_round() {
-        for (size_t i = 0; i < players.size(); ++i) {
-            auto& player = players[i];
-            if (!player->is_alive())
+        for (size_t i = 0; i < worms.size(); ++i) {
+            auto& worm = worms[i];
+            if (!worm.alive)
                 continue;
 
-            if (player->turn_direction == RIGHT)
-                player->angle += constants.turning_speed;
-            else if (player->turn_direction == LEFT)
-                player->angle -= constants.turning_speed;
+            if (ClientData const* client = clients.get(worm.client))
+                worm.turn_direction = client->player.turn_direction;
+            if (worm.turn_direction == RIGHT)
+                worm.angle += constants.turning_speed;
+            else if (worm.turn_direction == LEFT)
+                worm.angle -= constants.turning_speed;
 
-            Pixel before = player->position->as_pixel();
-            player->position->move_with_angle(player->angle);
-            Pixel after = player->position->as_pixel();
+            Pixel before = worm.position->as_pixel();
+            worm.position->move_with_angle(worm.angle);
+            Pixel after = worm.position->as_pixel();
             if (before == after) {
                 continue;
-            } else if (!board.contains(after) || board.is_eaten(after)) {
-                player->lose();
+            } else if (board.try_eat(after)) {
+                emit_pixel(i, after.x, after.y);
+            } else {
+                worm.alive = false;
                 --alive_players_num;
-                generate_event(PLAYER_ELIMINATED_NUM, std::make_unique<Data_PLAYER_ELIMINATED>(
-                        Data_PLAYER_ELIMINATED{static_cast<uint8_t>(i)}));
+                emit_player_eliminated(i);
                 if (alive_players_num <= 1)
                     _finished = true;
-            } else {
-                board.eat(after);
-                generate_event(PIXEL_NUM, std::make_unique<Data_PIXEL>(
-                        Data_PIXEL{static_cast<uint8_t>(i), after.x, after.y}));
             }
         }
         if (_finished) {
-            generate_event(GAME_OVER_NUM, std::make_unique<Data_GAME_OVER>());
+            emit_game_over();
         }
     }
 
-    void Game::generate_event(uint8_t event_type, std::unique_ptr<EventDataIface> data) {
-        uint32_t event_no = events.size();
-        std::unique_ptr<Event> event;
-
-        switch (event_type) {
-            case NEW_GAME_NUM: {
-                event = std::make_unique<Event_NEW_GAME>(
-                        event_no, event_type, *(dynamic_cast<Data_NEW_GAME*>(data.get())));
-                break;
-            }
-            case PIXEL_NUM: {
-                event = std::make_unique<Event_PIXEL>(
-                        event_no, event_type, *(dynamic_cast<Data_PIXEL*>(data.get())));
-                break;
-            }
-            case PLAYER_ELIMINATED_NUM:
-                event = std::make_unique<Event_PLAYER_ELIMINATED>(
-                        event_no, event_type, *(dynamic_cast<Data_PLAYER_ELIMINATED*>(data.get())));
-                break;
-            case GAME_OVER_NUM:
-                event = std::make_unique<Event_GAME_OVER>(
-                        event_no, event_type, *(dynamic_cast<Data_GAME_OVER*>(data.get())));
-                break;
-            default:
-                assert(false);
-        }
-        events.push_back(std::move(event));
+    void Game::emit_new_game(std::vector<std::string> player_names) {
+        event_log.append(NEW_GAME_NUM, Data_NEW_GAME{constants.width, constants.height,
+                                                     std::move(player_names)});
     }
 
-    void Game::enqueue_event_package(std::queue<UDPSendBuffer> &send_queue, size_t const next_event,
-                                     UDPEndpoint receiver) {
-        if (next_event >= events.size())
-            return;
-
-        auto* buff_ptr = &send_queue.emplace(receiver);
-        buff_ptr->pack_field(game_id);
+    void Game::emit_pixel(uint8_t const player_number, uint32_t const x, uint32_t const y) {
+        event_log.append(PIXEL_NUM, Data_PIXEL{player_number, x, y});
+    }
 
-        for (auto it = events.cbegin() + static_cast<long>(next_event);
-             it != events.cend(); ++it) {
-            auto& event = *it;
+    void Game::emit_player_eliminated(uint8_t const player_number) {
+        event_log.append(PLAYER_ELIMINATED_NUM, Data_PLAYER_ELIMINATED{player_number});
+    }
 
-            if (buff_ptr->remaining() < event->size()) {
-                // A new buffer is needed, as the previous one is full.
-                buff_ptr = &send_queue.emplace(receiver);
-                buff_ptr->pack_field(game_id);
-            }
+    void Game::emit_game_over() {
+        event_log.append(GAME_OVER_NUM, Data_GAME_OVER{});
+    }
 
-            event->pack(*buff_ptr);
+    size_t Game::enqueue_event_package(SendQueue &send_queue, size_t next_event,
+                                       sockaddr_in6 const& receiver, SendBudget *const budget) {
+        while (next_event < event_log.size()) {
+            if (budget != nullptr && !budget->try_spend())
+                break;
+            size_t end;
+            send_queue.push_back(event_log.datagram(next_event, end, receiver, budget == nullptr));
+            next_event = end;
         }
+        return next_event;
     }
 
-    void Game::respond_with_events(std::queue<UDPSendBuffer> &queue, int const sock,
-                                   sockaddr_in6 const &addr, uint32_t const next_event) {
-        enqueue_event_package(queue, next_event,UDPEndpoint{sock, addr});
+    bool Game::respond_with_events(SendQueue &queue, sockaddr_in6 const &addr,
+                                   uint32_t& next_event, SendBudget& budget) {
+        size_t const end = enqueue_event_package(queue, next_event, addr, &budget);
+        if (end >= event_log.size())
+            return true;
+        next_event = static_cast<uint32_t>(end);
+        return false;
     }
 
-    void Game::disseminate_new_events(std::queue<UDPSendBuffer> &queue, int const sock) {
-        for (auto& player: players) {
-            if (player->is_connected()) {
-                enqueue_event_package(queue, next_disseminated_event_no,
-                                      UDPEndpoint{sock, player->client()->address});
-            }
+    void Game::disseminate_new_events(SendQueue &queue, sockaddr_in6 const* const group) {
+        for (auto const& client : clients) {
+            if (group == nullptr || !client.player.is_observer())
+                enqueue_event_package(queue, next_disseminated_event_no, client.address);
         }
-
-        std::vector<decltype(observers.begin())> disconnected_observers;
-        for (auto it = observers.begin(); it != observers.end(); ++it) {
-            if (it->expired()) {
-                disconnected_observers.push_back(it);
-            } else {
-                enqueue_event_package(queue, next_disseminated_event_no,
-                                      UDPEndpoint{sock, it->lock()->client()->address});
-            }
-        }
-        for (auto& disconnected: disconnected_observers) {
-            observers.erase(disconnected);
-        }
-
-        next_disseminated_event_no = events.size();
+        if (group != nullptr)
+            enqueue_event_package(queue, next_disseminated_event_no, *group);
+        next_disseminated_event_no = event_log.size();
     }
 }
-
@@ -2,52 +2,89 @@
 #define ROBAKI_GAME_H
 
 #include <algorithm>
-#include <set>
-#include <queue>
+#include <vector>
 
-#include "Player.h"
 #include "ClientData.h"
 #include "../Common/Event.h"
 #include "Board.h"
+#include "EventLog.h"
+#include "GameArena.h"
 #include "RandomGenerator.h"
 
 namespace Worms {
     class Game {
     private:
         GameConstants const& constants;
-        Board board;
+        Board& board;
+        GameArena& _arena;
         uint32_t const game_id;
-        std::vector<std::unique_ptr<Event const>> events;
+        // Events are immutable, so their wire format is shared by all datagrams and receivers.
+        EventLog event_log;
         size_t next_disseminated_event_no = 0;
-        std::vector<std::shared_ptr<Player>> players;
-        size_t alive_players_num;
-        std::vector<std::weak_ptr<Player>> observers;
+        // Clients of the room, all of whom receive the game's events.
+        ClientSlots& clients;
+
+        /* Player's worm. Once the player has left, it keeps going its last way. */
+        struct Worm {
+            ClientHandle client;
+            uint8_t turn_direction;
+            bool alive = true;
+            std::optional<Position> position;
+            angle_t angle = 0;
+        };
+
+        std::pmr::vector<Worm> worms;
+        size_t alive_players_num = 0;
         bool _finished = false;
     public:
-        Game(GameConstants const& constants, RandomGenerator& rand,
-             std::set<std::shared_ptr<Player>, Player::Comparator> const& ready_players,
-             std::vector<std::weak_ptr<Player>> observers);
+        /* The board, cleared here, is used by the game until it finishes.
+         * The arena, reset beforehand, holds the game's memory as long as it exists.
+         * All players among the clients take part in the game; the clients are
+         * looked after by the room, and joining or leaving ones are taken into account. */
+        Game(GameConstants const& constants, Board& board, GameArena& arena,
+             RandomGenerator& rand, ClientSlots& clients);
+
+        [[nodiscard]] uint32_t id() const {
+            return game_id;
+        }
 
         [[nodiscard]] bool finished() const {
             return _finished;
         }
 
-        void add_observer(std::weak_ptr<Player> const& observer) {
-            observers.push_back(observer);
+        [[nodiscard]] GameArena& arena() const {
+            return _arena;
+        }
+
+        [[nodiscard]] EventLog const& events() const {
+            return event_log;
         }
 
         void play_round();
     private:
-        void generate_event(uint8_t event_type, std::unique_ptr<EventDataIface> data);
+        void emit_new_game(std::vector<std::string> player_names);
+
+        void emit_pixel(uint8_t player_number, uint32_t x, uint32_t y);
+
+        void emit_player_eliminated(uint8_t player_number);
+
+        void emit_game_over();
 
-        void enqueue_event_package(std::queue<UDPSendBuffer>& send_queue,
-                                   size_t const next_event, UDPEndpoint receiver);
+        /* Enqueues datagrams with events from next_event on, as long as budget allows
+         * (if given). Returns the first event left out, or the number of events. */
+        size_t enqueue_event_package(SendQueue& send_queue, size_t next_event,
+                                     sockaddr_in6 const& receiver,
+                                     SendBudget *budget = nullptr);
 
     public:
-        void respond_with_events(std::queue<UDPSendBuffer>& queue, int const sock,
-                                 sockaddr_in6 const& addr, uint32_t const next_event);
+        /* Returns true if all events from next_event on got enqueued.
+         * Otherwise, next_event is advanced past the enqueued ones. */
+        bool respond_with_events(SendQueue& queue, sockaddr_in6 const& addr,
+                                 uint32_t& next_event, SendBudget& budget);
 
-        void disseminate_new_events(std::queue<UDPSendBuffer>& queue, int const sock);
+        /* Sends new events to all clients, or, given a multicast group, to the group
+         * instead of observers, who fill gaps with catch-ups then. */
+        void disseminate_new_events(SendQueue& queue, sockaddr_in6 const* group = nullptr);
     };
 }
 
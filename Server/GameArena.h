@@ -0,0 +1,97 @@
+#ifndef ROBAKI_GAMEARENA_H
+#define ROBAKI_GAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace Worms {
+    /* Memory of a single game: its event index, players and observers are allocated
+     * one after another from a block and never freed one by one; the whole arena is
+     * reset at once instead, before the next game. The block is kept for that game,
+     * enlarged if this one did not fit in it. Reused, like the board, by games of a room. */
+    class GameArena {
+    private:
+        static constexpr size_t const INITIAL_BLOCK_SIZE = 64 * 1024;
+
+        /* Counts what is requested from the arena, forwarding it there. */
+        class Counter : public std::pmr::memory_resource {
+        private:
+            std::pmr::memory_resource* upstream = nullptr;
+
+        public:
+            uint64_t bytes = 0;
+            uint64_t allocations = 0;
+
+            void set_upstream(std::pmr::memory_resource* resource) {
+                upstream = resource;
+            }
+
+        private:
+            void* do_allocate(size_t const bytes_num, size_t const alignment) override {
+                bytes += bytes_num;
+                ++allocations;
+                return upstream->allocate(bytes_num, alignment);
+            }
+
+            void do_deallocate(void* p, size_t const bytes_num, size_t const alignment) override {
+                upstream->deallocate(p, bytes_num, alignment);
+            }
+
+            [[nodiscard]] bool do_is_equal(memory_resource const& other) const noexcept override {
+                return this == &other;
+            }
+        };
+
+        size_t block_size = 0;
+        std::unique_ptr<std::byte[]> block;
+        std::optional<std::pmr::monotonic_buffer_resource> arena;
+        Counter counter;
+
+    public:
+        GameArena() {
+            reset();
+        }
+
+        GameArena(GameArena const&) = delete;
+
+        GameArena& operator=(GameArena const&) = delete;
+
+        [[nodiscard]] std::pmr::memory_resource* resource() {
+            return &counter;
+        }
+
+        /* Bytes and allocations requested since the last reset. */
+        [[nodiscard]] uint64_t bytes() const {
+            return counter.bytes;
+        }
+
+        [[nodiscard]] uint64_t allocations() const {
+            return counter.allocations;
+        }
+
+        /* Frees all memory of the arena at once. Nothing allocated from it may be used
+         * afterwards, nor deallocated: containers using it must be gone already. */
+        void reset() {
+            if (counter.bytes > block_size || block == nullptr) {
+                // Room for what the previous game took, with some slack for the next one.
+                while (block_size < counter.bytes + counter.bytes / 4 ||
+                       block_size < INITIAL_BLOCK_SIZE) {
+                    block_size = block_size == 0 ? INITIAL_BLOCK_SIZE : block_size * 2;
+                }
+                arena.reset();
+                block = std::make_unique<std::byte[]>(block_size);
+                arena.emplace(block.get(), block_size);
+            } else {
+                arena->release();
+            }
+            counter.set_upstream(&*arena);
+            counter.bytes = counter.allocations = 0;
+        }
+    };
+}
+
+#endif //ROBAKI_GAMEARENA_H
@@ -0,0 +1,138 @@
+#include "Room.h"
+
+namespace Worms {
+    Room::Room(std::string name, GameConstants const& constants, RandomGenerator& rand)
+            : _name{std::move(name)}, constants{constants}, rand{rand}, board{this->constants},
+              outbox{OUTBOX_CAPACITY} {}
+
+    void Room::recycle(std::string name) {
+        assert(empty() && !current_game.has_value());
+        _name = std::move(name);
+        previous_game.reset();
+        catching_up.clear();
+        group.reset();
+        stats.reset();
+        // The board is cleared by the next game that starts.
+    }
+
+    ClientHandle Room::join(ClientData client) {
+        bool const observer = client.player.is_observer();
+        ClientHandle const handle = clients.insert(std::move(client));
+        if (!observer)
+            player_names.insert(clients.get(handle)->player.player_name, handle);
+        return handle;
+    }
+
+    void Room::leave(ClientHandle const handle) {
+        Player const& player = clients.get(handle)->player;
+        if (!player.is_observer())
+            player_names.erase(player.player_name);
+        clients.erase(handle);
+    }
+
+    bool Room::handle_heartbeat(ClientHandle const handle,
+                                ClientHeartbeatView const& heartbeat, SendQueue& queue,
+                                uint64_t const round_no) {
+        ClientData& client = *clients.get(handle);
+        client.player.turn_direction = heartbeat.turn_direction;
+
+        // The latest heartbeat tells best which events the client still lacks.
+        bool const was_deferred = client.pending_catch_up.has_value();
+        client.pending_catch_up = heartbeat.next_expected_event_no;
+        serve_catch_up(client, queue, round_no);
+        if (!was_deferred && client.pending_catch_up.has_value())
+            catching_up.push_back(handle);
+
+        if (!current_game.has_value() &&
+            (heartbeat.turn_direction == LEFT || heartbeat.turn_direction == RIGHT)) {
+            client.player.got_ready();
+            return try_start_game();
+        }
+        return false;
+    }
+
+    bool Room::play_rounds(uint64_t const round_no, uint64_t const rounds) {
+        if (current_game.has_value()) {
+            // Overdue rounds are played back to back, so that their events share datagrams.
+            for (uint64_t i = 0; i < rounds && !current_game->finished(); ++i) {
+                ++stats.rounds;
+                current_game->play_round();
+            }
+            current_game->disseminate_new_events(outbox, group.has_value() ? &*group : nullptr);
+        }
+        serve_deferred_catch_ups(outbox, round_no + rounds - 1);
+        return current_game.has_value() && current_game->finished();
+    }
+
+    void Room::finish_game() {
+        stats.take_queue_counters(outbox.take_counters());
+        stats.arena_bytes = current_game->arena().bytes();
+        stats.arena_allocations = current_game->arena().allocations();
+        stats.report(current_game->id());
+        stats.reset();
+        previous_game.emplace(std::move(current_game.value()));
+        current_game.reset();
+    }
+
+    bool Room::try_start_game() {
+        // Check if a game can be started.
+        size_t players = 0;
+        for (auto const& client : clients) {
+            if (client.player.is_observer())
+                continue;
+            if (!client.player.is_ready())
+                return false;
+            ++players;
+        }
+        if (players < 2)
+            return false;
+
+        // start the game!
+        drop_catch_ups();
+        GameArena& arena = previous_game.has_value() && &previous_game->arena() == &arenas[0]
+                           ? arenas[1] : arenas[0];
+        arena.reset();
+        current_game.emplace(constants, board, arena, rand, clients);
+        return true;
+    }
+
+    void Room::serve_catch_up(ClientData& client, SendQueue& queue, uint64_t const round_no) {
+        auto& game = responding_game();
+        if (!game.has_value()) {
+            client.pending_catch_up.reset();
+            return;
+        }
+        client.budget.refill(round_no);
+        bool const was_deferred = client.pending_catch_up.has_value();
+        if (game->respond_with_events(queue, client.address, *client.pending_catch_up,
+                                      client.budget)) {
+            client.pending_catch_up.reset();
+        } else if (!was_deferred) {
+            ++stats.deferred_catch_ups;
+        }
+    }
+
+    void Room::serve_deferred_catch_ups(SendQueue& queue, uint64_t const round_no) {
+        size_t kept = 0;
+        for (ClientHandle const handle : catching_up) {
+            ClientData* const client = clients.get(handle);
+            if (client == nullptr) {
+                ++stats.dropped_catch_ups;
+                continue;
+            }
+            serve_catch_up(*client, queue, round_no);
+            if (client->pending_catch_up.has_value())
+                catching_up[kept++] = handle;
+        }
+        catching_up.resize(kept);
+    }
+
+    void Room::drop_catch_ups() {
+        for (ClientHandle const handle : catching_up) {
+            if (ClientData* const client = clients.get(handle))
+                client->pending_catch_up.reset();
+            ++stats.dropped_catch_ups;
+        }
+        catching_up.clear();
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef ROBAKI_ROOM_H
+#define ROBAKI_ROOM_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "../Common/Buffer.h"
+#include "../Common/ClientHeartbeat.h"
+#include "ClientData.h"
+#include "FlatHashMap.h"
+#include "Game.h"
+#include "GameArena.h"
+#include "GameConstants.h"
+#include "RandomGenerator.h"
+#include "Stats.h"
+
+namespace Worms {
+    /* Independent match hosted by the server: its own players, observers and games,
+     * played on its own board. Rooms share the server's socket and round timer.
+     * Once abandoned by all clients, a room is cleared and recycled, board included. */
+    class Room {
+    private:
+        // Enough for a round of a crowded room; catch-ups beyond it are dropped.
+        static constexpr size_t const OUTBOX_CAPACITY = 1 << 10;
+
+        std::string _name;
+        // The server's defaults, as heartbeats have no way to choose others.
+        GameConstants const constants;
+        RandomGenerator& rand;
+        Board board;
+        // Games use them by turns, so that the current one is never the previous one's.
+        std::array<GameArena, 2> arenas;
+        std::optional<Game> current_game;
+        std::optional<Game> previous_game;
+        Stats stats;
+        // Datagrams of the room's rounds, which may be played outside of the server's thread.
+        SendQueue outbox;
+        // Multicast group where live events are published, if any.
+        std::optional<sockaddr_in6> group;
+
+        // Connected clients, observers included; games send their events to all of them.
+        ClientSlots clients;
+        FlatHashMap<std::string, ClientHandle> player_names;
+        // Clients whose catch-ups have been deferred; some of them may be gone already.
+        std::vector<ClientHandle> catching_up;
+
+    public:
+        Room(std::string name, GameConstants const& constants, RandomGenerator& rand);
+
+        [[nodiscard]] std::string const& name() const {
+            return _name;
+        }
+
+        [[nodiscard]] GameConstants const& game_constants() const {
+            return constants;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return clients.empty();
+        }
+
+        [[nodiscard]] bool playing() const {
+            return current_game.has_value();
+        }
+
+        /* Estimated cost of playing a round of the room. */
+        [[nodiscard]] uint64_t load() const {
+            return 1 + catching_up.size() + (current_game.has_value() ? 2 * clients.size() : 0);
+        }
+
+        [[nodiscard]] bool accepts(std::string const& player_name) const {
+            return !player_names.contains(player_name);
+        }
+
+        /* Forgets all games and pending catch-ups, so that the room can host another match. */
+        void recycle(std::string name);
+
+        /* Makes games publish live events to the group, whose spectators are then
+         * sent no live events directly; none stops it. */
+        void publish_to(std::optional<sockaddr_in6> const& multicast_group) {
+            group = multicast_group;
+        }
+
+        /* Returns the handle the client is known by in the room from now on. */
+        ClientHandle join(ClientData client);
+
+        void leave(ClientHandle handle);
+
+        /* Returns the client, or nullptr if it has left already. */
+        ClientData* client(ClientHandle const handle) {
+            return clients.get(handle);
+        }
+
+        /* Handles a heartbeat of a client who has joined this room.
+         * Returns true if it made a new game start. */
+        bool handle_heartbeat(ClientHandle handle, ClientHeartbeatView const& heartbeat,
+                              SendQueue& queue, uint64_t round_no);
+
+        /* Plays rounds of the current game, if there is one, from round_no on, then sends
+         * their events at once and serves deferred catch-ups, enqueuing datagrams to
+         * the outbox. Returns true if the game has finished; it is to be then concluded
+         * with finish_game(), once network statistics are added to stats. */
+        bool play_rounds(uint64_t round_no, uint64_t rounds);
+
+        SendQueue& output() {
+            return outbox;
+        }
+
+        void finish_game();
+
+        Stats& statistics() {
+            return stats;
+        }
+
+    private:
+        bool try_start_game();
+
+        /* Game whose events are sent to clients in response to their heartbeats. */
+        std::optional<Game>& responding_game() {
+            return current_game.has_value() ? current_game : previous_game;
+        }
+
+        /* Enqueues the client's pending catch-up, as far as its send budget allows.
+         * The rest of it stays pending until the following rounds. */
+        void serve_catch_up(ClientData& client, SendQueue& queue, uint64_t round_no);
+
+        void serve_deferred_catch_ups(SendQueue& queue, uint64_t round_no);
+
+        /* Abandons all pending catch-ups, as events they refer to are no longer sent. */
+        void drop_catch_ups();
+    };
+}
+
+#endif //ROBAKI_ROOM_H
@@ -0,0 +1,130 @@
+#include "RoomScheduler.h"
+
+#include <algorithm>
+
+namespace Worms {
+    RoomScheduler::RoomScheduler(unsigned const threads) : workers(std::max(1u, threads)) {
+        for (size_t i = 1; i < workers.size(); ++i) {
+            this->threads.emplace_back(&RoomScheduler::run, this, i);
+        }
+    }
+
+    RoomScheduler::~RoomScheduler() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        started.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void RoomScheduler::play_rounds(std::vector<Job>& round_jobs, uint64_t const first_round,
+                                    uint64_t const rounds_num) {
+        if (workers.size() == 1) {
+            for (auto& job : round_jobs) {
+                job.finished = job.room->play_rounds(first_round, rounds_num);
+            }
+            return;
+        }
+
+        jobs = &round_jobs;
+        round_no = first_round;
+        rounds = rounds_num;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            remaining = round_jobs.size();
+        }
+        // A thread late for the previous round may already take jobs from now on.
+        assign();
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            ++generation;
+        }
+        started.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock{mutex};
+        done.wait(lock, [this] { return remaining == 0; });
+        jobs = nullptr;
+    }
+
+    void RoomScheduler::assign() {
+        // Longest processing time first: the heaviest room goes to the least loaded thread.
+        order.resize(jobs->size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        room_loads.resize(jobs->size());
+        for (size_t i = 0; i < jobs->size(); ++i) {
+            room_loads[i] = (*jobs)[i].room->load();
+        }
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return room_loads[a] > room_loads[b];
+        });
+
+        loads.assign(workers.size(), 0);
+        for (size_t const job : order) {
+            size_t const lightest = std::min_element(loads.begin(), loads.end()) - loads.begin();
+            loads[lightest] += room_loads[job];
+            std::lock_guard<std::mutex> lock{workers[lightest].mutex};
+            workers[lightest].jobs.push_back(job);
+        }
+    }
+
+    void RoomScheduler::run(size_t const self) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                started.wait(lock, [this, seen] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            work(self);
+        }
+    }
+
+    void RoomScheduler::work(size_t const self) {
+        size_t job;
+        size_t played = 0;
+        while (pop(self, job) || steal(self, job)) {
+            auto& [room, finished] = (*jobs)[job];
+            finished = room->play_rounds(round_no, rounds);
+            ++played;
+        }
+        if (played == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        remaining -= played;
+        if (remaining == 0)
+            done.notify_one();
+    }
+
+    bool RoomScheduler::pop(size_t const self, size_t& job) {
+        auto& worker = workers[self];
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (worker.jobs.empty())
+            return false;
+        job = worker.jobs.front();
+        worker.jobs.pop_front();
+        return true;
+    }
+
+    bool RoomScheduler::steal(size_t const self, size_t& job) {
+        for (size_t i = 1; i < workers.size(); ++i) {
+            auto& victim = workers[(self + i) % workers.size()];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef ROBAKI_ROOMSCHEDULER_H
+#define ROBAKI_ROOMSCHEDULER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Room.h"
+
+namespace Worms {
+    /* Pool of threads playing rounds of rooms in parallel, the calling thread included.
+     * Rooms are spread among threads by their load, heaviest first, each time anew;
+     * a thread which runs out of rooms steals them from the back of the others' deques.
+     * A room is played by a single thread and only writes to its own outbox, so
+     * what it sends does not depend on scheduling. */
+    class RoomScheduler {
+    public:
+        struct Job {
+            Room* room;
+            bool finished = false;
+        };
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<size_t> jobs;
+        };
+
+        std::vector<Worker> workers;
+        std::vector<std::thread> threads;
+        std::vector<uint64_t> loads;
+        std::vector<uint64_t> room_loads;
+        std::vector<size_t> order;
+
+        std::mutex mutex;
+        std::condition_variable started;
+        std::condition_variable done;
+        // Incremented with every round, which wakes up threads to play it.
+        uint64_t generation = 0;
+        size_t remaining = 0;
+        bool stopping = false;
+
+        std::vector<Job>* jobs = nullptr;
+        uint64_t round_no = 0;
+        uint64_t rounds = 0;
+
+    public:
+        /* Starts threads - 1 threads; with threads == 1, rounds are played serially. */
+        explicit RoomScheduler(unsigned threads);
+
+        ~RoomScheduler();
+
+        /* Plays rounds of every room of jobs (see Room::play_rounds), setting finished
+         * of rooms whose games have just finished. Returns once all rooms have played. */
+        void play_rounds(std::vector<Job>& jobs, uint64_t round_no, uint64_t rounds);
+
+    private:
+        void assign();
+
+        void run(size_t self);
+
+        /* Plays rooms of its own, then stolen ones, until there are none left. */
+        void work(size_t self);
+
+        bool pop(size_t self, size_t& job);
+
+        bool steal(size_t self, size_t& job);
+    };
+}
+
+#endif //ROBAKI_ROOMSCHEDULER_H
@@ -1,178 +1,261 @@
 #include "Server.h"
 
 namespace Worms {
-    Server::Server(uint16_t const port, uint32_t const seed, Worms::GameConstants constants)
-            : sock{socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP)},
+    Server::Server(uint16_t const port, uint32_t const seed, Worms::GameConstants constants,
+                   Reactor::Backend const backend, unsigned const workers,
+                   size_t const queue_capacity, unsigned const room_threads,
+                   size_t const max_rooms, uint64_t const max_catch_up_rounds,
+                   std::optional<sockaddr_in6> const& multicast_group)
+            : sock{workers > 0 ? -1 : open_server_socket(port, false,
+                                                         multicast_interface(multicast_group))},
               round_timer{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)},
-              epoll{round_timer},
+              reactor{make_reactor(backend, round_timer, true)},
               rand{RandomGenerator{seed}},
               constants{constants},
               round_duration_ns{NS_IN_SEC / constants.round_per_sec},
-              receive_buff{sock} {
-        if (sock < 0)
-            syserr(errno, "opening socket");
+              idle_rounds{(DISCONNECT_THRESHOLD + round_duration_ns - 1) / round_duration_ns},
+              max_rooms{max_rooms},
+              max_catch_up_rounds{max_catch_up_rounds},
+              multicast_group{multicast_group},
+              send_queue{SendQueue::DEFAULT_CAPACITY, queue_capacity},
+              batch_sender{sock},
+              receive_ring{sock, RECEIVE_BATCH},
+              idle_timers{idle_rounds},
+              scheduler{room_threads} {
         if (round_timer < 0)
             syserr(errno, "opening timer fd");
 
-        struct sockaddr_in6 server_address{};
-        server_address.sin6_family = AF_INET6;
-        server_address.sin6_addr = in6addr_any;
-        server_address.sin6_port = htobe16(port);
+        reactor->watch_fd_for_input(round_timer);
+        if (workers == 0) {
+            reactor->add_fd(sock);
+            reactor->watch_for_datagrams(receive_ring);
+        } else {
+            reactor->add_fd(inbox.fd());
+            reactor->watch_fd_for_input(inbox.fd());
+            for (unsigned i = 0; i < workers; ++i) {
+                shards.push_back(std::make_unique<Shard>(port, backend, inbox, queue_capacity,
+                                                         multicast_interface(multicast_group)));
+                shard_queues.emplace_back(SendQueue::DEFAULT_CAPACITY, queue_capacity);
+            }
+            for (auto& shard : shards) {
+                shard->start();
+            }
+        }
+        // The default room is opened up front, so that other rooms never leave it out.
+        room_named("");
+    }
 
-        verify(bind(sock, (struct sockaddr *) &server_address,
-                    sizeof(server_address)), "bind");
+    void Server::disconnect_idles() {
+        idle_timers.expire(round_no, idle_clients);
+        for (auto const& endpoint : idle_clients) {
+            disconnect_client(endpoint);
+        }
+        idle_clients.clear();
+    }
 
-        verify(fcntl(sock, F_SETFL, O_NONBLOCK), "fcntl");
+    void Server::round_routine(uint64_t const expirations) {
+        // Rounds overdue beyond the limit are skipped: they pass, yet nothing moves in them.
+        uint64_t const rounds = std::min(expirations, max_catch_up_rounds);
+        round_no += expirations - rounds;
 
-        epoll.add_fd(sock);
-        epoll.watch_fd_for_input(round_timer);
-        epoll.watch_fd_for_input(sock);
-    }
+        struct timespec start{};
+        verify(clock_gettime(CLOCK_MONOTONIC, &start), "clock_gettime");
 
-    void Server::disconnect_idles() {
-        std::vector<decltype(connected_clients.begin())> to_disconnect;
-        for (auto it = connected_clients.begin(); it != connected_clients.end(); ++it) {
-            if ((round_no - (*it)->last_heartbeat_round_no) * round_duration_ns
-                >= DISCONNECT_THRESHOLD) {
-                to_disconnect.push_back(it);
-            }
+        round_jobs.clear();
+        for (auto& [_, room] : rooms) {
+            round_jobs.push_back(RoomScheduler::Job{room.get()});
         }
-        for (auto it : to_disconnect) {
-            disconnect_client(it);
+        scheduler.play_rounds(round_jobs, round_no, rounds);
+
+        // Rooms' datagrams are sent in the order of their names, however they were played.
+        for (auto& job : round_jobs) {
+            job.room->output().move_to(send_queue);
         }
-    }
 
-    void Server::round_routine() {
-        if (current_game.has_value()) {
-            current_game->play_round();
-            current_game->disseminate_new_events(send_queue, sock);
-            if (current_game->finished()) {
-                previous_game.emplace(std::move(current_game.value()));
-                current_game.reset();
+        struct timespec end{};
+        verify(clock_gettime(CLOCK_MONOTONIC, &end), "clock_gettime");
+        bool const late = static_cast<uint64_t>(end.tv_sec - start.tv_sec) * NS_IN_SEC
+                          + end.tv_nsec - start.tv_nsec > round_duration_ns;
+
+        for (auto& [room, finished] : round_jobs) {
+            if (room->playing() || finished) {
+                auto& stats = room->statistics();
+                if (late)
+                    ++stats.late_rounds;
+                if (expirations > 1) {
+                    ++stats.lagging_ticks;
+                    stats.max_tick_lag = std::max(stats.max_tick_lag, expirations - 1);
+                    stats.skipped_rounds += expirations - rounds;
+                }
+            }
+            if (finished) {
+                take_egress(room->statistics());
+                room->finish_game();
+                close_if_abandoned(*room);
             }
         }
 
-        ++round_no;
+        round_no += rounds;
 
         if (!drain_queue())
-            epoll.watch_fd_for_output(sock);
+            reactor->watch_fd_for_output(sock);
     }
 
-    void Server::try_start_game() {
-        // Check if a game can be started.
-        if (connected_players.size() >= 2) {
-            bool all_ready = true;
-            for (auto& player: connected_players) {
-                if (!player->is_ready()) {
-                    all_ready = false;
-                    break;
-                }
+    Room* Server::room_named(std::string const& name) {
+        auto it = rooms.find(name);
+        if (it == rooms.end()) {
+            // Any host may name any room, so their number is what bounds their memory.
+            if (rooms.size() >= max_rooms)
+                return nullptr;
+            std::unique_ptr<Room> room;
+            if (idle_rooms.empty()) {
+                room = std::make_unique<Room>(name, constants, rand);
+            } else {
+                room = std::move(idle_rooms.back());
+                idle_rooms.pop_back();
+                room->recycle(name);
             }
-            if (all_ready) { // start the game!
-                std::vector<std::weak_ptr<Player>> observers;
-                for (auto &observer: connected_unnames) {
-                    observers.push_back(std::weak_ptr<Player>{observer});
-                }
-                current_game.emplace(constants, rand, connected_players, std::move(observers));
+            // Only the default room is published, as a group carries a single game at a time.
+            if (name.empty())
+                room->publish_to(multicast_group);
+            it = rooms.emplace(name, std::move(room)).first;
+        }
+        return it->second.get();
+    }
 
-                if (!drain_queue())
-                    epoll.watch_fd_for_output(sock);
-            }
+    void Server::close_if_abandoned(Room& room) {
+        // The default room stays open, so that it keeps answering with its last game.
+        if (room.name().empty() || !room.empty() || room.playing())
+            return;
+        auto it = rooms.find(room.name());
+        idle_rooms.push_back(std::move(it->second));
+        rooms.erase(it);
+    }
+
+    bool Server::drain_queue() {
+        if (shards.empty())
+            return reactor->send(batch_sender, send_queue);
+
+        // Datagrams to each client go through a single shard, so that they stay in order.
+        send_queue.distribute([this](sockaddr_in6 const& destination) -> SendQueue& {
+            return shard_queues[shard_of(destination)];
+        });
+        for (size_t i = 0; i < shards.size(); ++i) {
+            shards[i]->post(shard_queues[i]);
         }
+        return true;
     }
 
-    void Server::handle_heartbeat() {
-        auto sender = receive_buff.populate();
-        try {
-            // The following construction may fail with BadData
-            // if client sent us invalid heartbeat.
-            ClientHeartbeat heartbeat{receive_buff};
+    size_t Server::shard_of(sockaddr_in6 const& addr) const {
+        uint32_t hash = be16toh(addr.sin6_port);
+        for (uint8_t const byte : addr.sin6_addr.s6_addr) {
+            hash = hash * 31 + byte;
+        }
+        return hash % shards.size();
+    }
 
-            if (heartbeat.player_name.size() > 20)
-                return; // player name too long
+    void Server::take_egress(Stats& stats) {
+        stats.take_egress(batch_sender);
+        stats.take_queue_counters(send_queue.take_counters());
+        for (auto& queue : shard_queues) {
+            stats.take_queue_counters(queue.take_counters());
+        }
+        for (auto& shard : shards) {
+            shard->take_egress(stats);
+        }
+    }
 
-            if (!std::all_of(heartbeat.player_name.begin(), heartbeat.player_name.end(),
-                             [](char const c) -> bool {
-                                 return c >= 33 && c <= 126;
-                             })) {
-                return; // invalid characters in player name
+    void Server::handle_heartbeats() {
+        // The reactor may be edge-triggered, so the socket has to be drained completely.
+        // A batch smaller than the ring's capacity means that no more datagrams are pending.
+        size_t received;
+        do {
+            received = reactor->receive(receive_ring);
+            for (size_t i = 0; i < received; ++i) {
+                handle_heartbeat(receive_ring.sender(i), receive_ring.slot(i));
             }
+        } while (received == receive_ring.capacity());
+    }
 
-            auto client_ptr = connected_clients.find(sender);
-            if (connected_clients.find(sender) == connected_clients.end()) {
-                if (player_names.find(heartbeat.player_name) == player_names.end()) {
-                    connect_client(sender, std::move(heartbeat));
-                } // else ignore and discard heartbeat
-            } else { // client with the same address had been connected
-                auto &client = *client_ptr;
-                if (client->session_id == heartbeat.session_id) {
-                    client->heart_has_beaten(round_no);
-                    client->player.turn_direction = heartbeat.turn_direction;
-
-                    if (current_game.has_value()) {
-                        current_game->respond_with_events(send_queue, sock, sender,
-                                                          heartbeat.next_expected_event_no);
-                    } else if (previous_game.has_value()) {
-                        previous_game->respond_with_events(send_queue, sock, sender,
-                                                           heartbeat.next_expected_event_no);
-                    }
-
-                    if (!current_game.has_value() &&
-                        (heartbeat.turn_direction == LEFT || heartbeat.turn_direction == RIGHT)) {
-                        client->player.got_ready();
-                        try_start_game();
-                    }
-
-                } else if (client->session_id > heartbeat.session_id) {
-                    disconnect_client(client_ptr);
-                    connect_client(sender, std::move(heartbeat));
-                }
-            }
+    void Server::handle_heartbeat(sockaddr_in6 const& sender, UDPReceiveBuffer& buff) {
+        try {
+            // The following construction may fail with BadData
+            // if client sent us invalid heartbeat.
+            ClientHeartbeatView const heartbeat{buff};
+            ClientRef const* ref = connected_clients.find(Endpoint::of(sender));
+            // Names are copied, and validated, only for heartbeats of new sessions.
+            if ((ref == nullptr || !handle_established_heartbeat(*ref, heartbeat)) &&
+                heartbeat.has_valid_player_name())
+                handle_new_session(sender, ref, ClientHeartbeat{heartbeat});
         } catch (BadData const&) {
             // Ignore invalid heartbeat.
-            receive_buff.discard();
+            buff.discard();
         }
     }
 
-    void Server::connect_client(sockaddr_in6 const &addr, ClientHeartbeat heartbeat) {
-        auto player = std::make_shared<Player>(std::move(heartbeat.player_name),
-                                               heartbeat.turn_direction);
-
-        auto [client_it, _] = connected_clients.emplace(std::make_shared<ClientData>(
-                addr, heartbeat.session_id, round_no, *player));
+    void Server::handle_inbound_heartbeats() {
+        inbox.take(inbound);
+        for (auto& [sender, heartbeat] : inbound) {
+            handle_heartbeat(sender, std::move(heartbeat));
+        }
+        inbound.clear();
+    }
 
-        player->attach_to_client(*client_it);
+    bool Server::handle_established_heartbeat(ClientRef const& ref,
+                                              ClientHeartbeatView const& heartbeat) {
+        ClientData& client = *ref.room->client(ref.handle);
+        if (client.session_id != heartbeat.session_id)
+            return false;
 
-        if (player->is_observer()) {
-            connected_unnames.insert(player);
-        }
-        else {
-            connected_players.insert(player);
-            player_names.insert(player->player_name);
+        client.heart_has_beaten(round_no);
+        idle_timers.rearm(ref.idle_timer, round_no + idle_rounds);
+        if (ref.room->handle_heartbeat(ref.handle, heartbeat, send_queue, round_no)) {
+            if (!drain_queue())
+                reactor->watch_fd_for_output(sock);
         }
+        return true;
+    }
 
-        if (current_game.has_value()) {
-            current_game->add_observer(player);
-        }
+    void Server::handle_heartbeat(sockaddr_in6 const& sender, ClientHeartbeat heartbeat) {
+        ClientRef const* ref = connected_clients.find(Endpoint::of(sender));
+        if (ref == nullptr || !handle_established_heartbeat(*ref, heartbeat.view()))
+            handle_new_session(sender, ref, std::move(heartbeat));
     }
 
-    void Server::disconnect_client(
-            std::set<std::shared_ptr<ClientData>, ClientData::Comparator>::iterator client_ptr) {
-        auto& client = *client_ptr;
+    void Server::handle_new_session(sockaddr_in6 const& sender, ClientRef const* ref,
+                                    ClientHeartbeat heartbeat) {
+        if (ref == nullptr) {
+            connect_client(sender, std::move(heartbeat));
+        } else if (ref->room->client(ref->handle)->session_id > heartbeat.session_id) {
+            // client with the same address had been connected
+            disconnect_client(Endpoint::of(sender));
+            connect_client(sender, std::move(heartbeat));
+        }
+    }
 
-        if (client->player.is_observer()) {
-            auto it = connected_unnames.find(client->player);
-            auto player_temp_copy = *it;
-            connected_unnames.erase(it);
-            player_temp_copy->disconnect();
-        } else {
-            player_names.erase(client->player.player_name);
-            auto it = connected_players.find(client->player);
-            auto player_temp_copy = *it;
-            connected_players.erase(it);
-            player_temp_copy->disconnect();
+    void Server::connect_client(sockaddr_in6 const &addr, ClientHeartbeat heartbeat) {
+        Room* const room = room_named(heartbeat.room);
+        if (room == nullptr)
+            return; // too many rooms are open, ignore and discard heartbeat
+        if (!room->accepts(heartbeat.player_name)) {
+            // A room opened just for this heartbeat is not kept open.
+            close_if_abandoned(*room);
+            return;
         }
-        connected_clients.erase(client_ptr);
+        ClientHandle const handle = room->join(ClientData{
+                addr, heartbeat.session_id, round_no,
+                Player{std::move(heartbeat.player_name), heartbeat.turn_direction}});
+        Endpoint const endpoint = Endpoint::of(addr);
+        connected_clients.insert(endpoint, ClientRef{
+                room, handle, idle_timers.arm(endpoint, round_no + idle_rounds)});
+    }
+
+    void Server::disconnect_client(Endpoint const& endpoint) {
+        ClientRef const ref = *connected_clients.find(endpoint);
+        connected_clients.erase(endpoint);
+        idle_timers.cancel(ref.idle_timer);
+        ref.room->leave(ref.handle);
+        close_if_abandoned(*ref.room);
     }
 
     void Server::mainloop() {
@@ -183,25 +266,29 @@ namespace Worms {
             struct itimerspec conf{.it_interval = spec, .it_value = spec};
             verify(timerfd_settime(round_timer, 0, &conf, nullptr), "timerfd_settime");
         }
-        struct epoll_event event{};
         for (;;) {
-            event = epoll.wait();
-            if (event.data.fd == round_timer) {
-                disconnect_idles();
-                uint64_t expirations;
-                if (read(round_timer, &expirations, sizeof(expirations)) != -1) {
-                    for (size_t i = 0; i < expirations; ++i) {
-                        round_routine();
-                    }
+            for (auto const& event : reactor->wait()) {
+                if (event.data.fd == round_timer) {
+                    disconnect_idles();
+                    uint64_t const expirations = reactor->timer_expirations();
+                    if (expirations > 0)
+                        round_routine(expirations);
+                    continue;
+                }
+                if (event.data.fd == inbox.fd()) {
+                    handle_inbound_heartbeats();
+                    continue;
+                }
+                if (event.events & EPOLLOUT) {
+                    // drain server queue
+                    if (drain_queue()) // if no delay this time
+                        reactor->stop_watching_fd_for_output(sock);
+                    // else keep us notified about socket possibility to send
+                }
+                if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    // receive heartbeats from clients
+                    handle_heartbeats();
                 }
-            } else if (event.events & EPOLLOUT) {
-                // drain server queue
-                if (drain_queue()) // if no delay this time
-                    epoll.stop_watching_fd_for_output(sock);
-                // else keep us notified about socket possibility to send
-            } else {
-                // receive heartbeat from _client
-                handle_heartbeat();
             }
         }
     }
@@ -4,68 +4,142 @@
 #include <fcntl.h>
 #include <sys/timerfd.h>
 
-#include <queue>
-#include <set>
+#include <map>
 
 #include "../Common/Buffer.h"
 #include "RandomGenerator.h"
-#include "../Common/Epoll.h"
+#include "../Common/Reactor.h"
 #include "../Common/ClientHeartbeat.h"
-#include "Player.h"
 #include "Game.h"
+#include "Room.h"
+#include "RoomScheduler.h"
+#include "Shard.h"
+#include "Stats.h"
+#include "TimerWheel.h"
 
 namespace Worms {
     class Server {
     private:
         static constexpr uint64_t const NS_IN_SEC = 1'000'000'000;
         static constexpr uint64_t const DISCONNECT_THRESHOLD = 2 * NS_IN_SEC;
+        static constexpr size_t const RECEIVE_BATCH = 64;
 
         int const sock;
         int const round_timer;
-        Epoll epoll;
+        std::unique_ptr<Reactor> reactor;
         uint64_t round_no = 0;
         RandomGenerator rand;
+        // Constants every room is opened with.
         GameConstants const constants;
         uint64_t const round_duration_ns;
-        std::optional<Game> current_game;
-        std::optional<Game> previous_game;
-        std::queue<UDPSendBuffer> send_queue;
-        UDPReceiveBuffer receive_buff;
-
-        std::set<std::shared_ptr<ClientData>, ClientData::Comparator> connected_clients;
-        std::set<std::shared_ptr<Player>, Player::Comparator> connected_players;
-        std::set<std::shared_ptr<Player>, Player::Comparator> connected_unnames;
-        std::set<std::string> player_names;
+        // Rounds without heartbeats after which a client is disconnected.
+        uint64_t const idle_rounds;
+        size_t const max_rooms;
+        uint64_t const max_catch_up_rounds;
+        // Group where the default room publishes live events, if any.
+        std::optional<sockaddr_in6> const multicast_group;
+        SendQueue send_queue;
+        UDPBatchSender batch_sender;
+        UDPReceiveRing receive_ring;
+
+        // With shards, the server's thread only runs the game, and the sockets are theirs.
+        Inbox inbox;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::vector<SendQueue> shard_queues;
+        std::vector<InboundHeartbeat> inbound;
+
+        /* Where a client is kept: clients belong to their rooms. */
+        struct ClientRef {
+            Room* room;
+            ClientHandle handle;
+            // Due idle_rounds after the client's latest heartbeat.
+            TimerWheel<Endpoint>::Timer idle_timer;
+        };
+
+        FlatHashMap<Endpoint, ClientRef, Endpoint::Hash> connected_clients;
+        TimerWheel<Endpoint> idle_timers;
+        std::vector<Endpoint> idle_clients;
+        RoomScheduler scheduler;
+        std::vector<RoomScheduler::Job> round_jobs;
+
+        // Rooms by name; the default one is named "".
+        std::map<std::string, std::unique_ptr<Room>> rooms;
+        // Rooms abandoned between games, kept for reuse, so that their boards need not
+        // be allocated anew.
+        std::vector<std::unique_ptr<Room>> idle_rooms;
 
     public:
-        explicit Server(uint16_t const port, uint32_t const seed, GameConstants constants);
+        /* With workers > 0, that many shards receive and send datagrams in their own
+         * threads, whereas the server's thread handles heartbeats they have parsed.
+         * Each send queue holds up to queue_capacity datagrams (see SendQueue).
+         * Clients choose their rooms with heartbeats; all rooms share the sockets.
+         * Rounds of rooms are played by room_threads threads (see RoomScheduler).
+         * At most max_rooms are open at once, the default one included; heartbeats naming
+         * another room are ignored until some room is abandoned.
+         * After a stall, at most max_catch_up_rounds overdue rounds are played at once.
+         * Given a multicast group, the default room publishes live events to it,
+         * and its spectators are expected to have joined it (see Room::publish_to). */
+        Server(uint16_t const port, uint32_t const seed, GameConstants constants,
+               Reactor::Backend backend, unsigned workers, size_t queue_capacity,
+               unsigned room_threads, size_t max_rooms, uint64_t max_catch_up_rounds,
+               std::optional<sockaddr_in6> const& multicast_group);
 
         ~Server() {
-            close(sock);
+            if (sock >= 0)
+                close(sock);
             close(round_timer);
         }
     private:
+        /* Disconnects clients whose idle timers have expired by now. */
         void disconnect_idles();
 
-        void round_routine();
+        /* Plays rounds due since the previous call, as one batch (see Room::play_rounds),
+         * but no more than max_catch_up_rounds of them. */
+        void round_routine(uint64_t expirations);
 
-        void try_start_game();
+        /* Finds the room of the given name, opening it if there is none,
+         * unless max_rooms are open already; then returns nullptr. */
+        Room* room_named(std::string const& name);
 
-        bool drain_queue() {
-            while (!send_queue.empty()) {
-                if (send_queue.front().flush())
-                    send_queue.pop();
-                else
-                    return false;
-            }
-            return true;
-        }
+        /* Puts the room aside for reuse, if it is empty and has no game going on. */
+        void close_if_abandoned(Room& room);
+
+        /* Sends enqueued datagrams (see UDPBatchSender) through the reactor,
+         * or hands them over to the shards, if there are any.
+         * Returns false if the socket clogged up before the queue got emptied. */
+        bool drain_queue();
+
+        /* Index of the shard sending datagrams to the given client. */
+        size_t shard_of(sockaddr_in6 const& addr) const;
+
+        /* Network counters are shared by all rooms, so they are attributed
+         * to the room whose game has just finished. */
+        void take_egress(Stats& stats);
+
+        /* Receives a batch of heartbeats and handles each of them in turn. */
+        void handle_heartbeats();
+
+        void handle_heartbeat(sockaddr_in6 const& sender, UDPReceiveBuffer& buff);
+
+        /* Handles heartbeats parsed by shards. */
+        void handle_inbound_heartbeats();
+
+        /* Handles a heartbeat of the client's established session, which needs no names.
+         * Returns false if the heartbeat belongs to another session. */
+        bool handle_established_heartbeat(ClientRef const& ref,
+                                          ClientHeartbeatView const& heartbeat);
+
+        /* Handles a heartbeat parsed by a shard. */
+        void handle_heartbeat(sockaddr_in6 const& sender, ClientHeartbeat heartbeat);
 
-        void handle_heartbeat();
+        /* Handles a heartbeat of a session not established yet, given the client
+         * connected from the sender already, if any, as found by the caller. */
+        void handle_new_session(sockaddr_in6 const& sender, ClientRef const* ref,
+                                ClientHeartbeat heartbeat);
 
         void connect_client(sockaddr_in6 const& addr, ClientHeartbeat heartbeat);
 
-        void disconnect_client(decltype(connected_clients.begin()) client_ptr);
+        void disconnect_client(Endpoint const& endpoint);
 
     public:
         [[noreturn]] void mainloop();
@@ -0,0 +1,199 @@
+#include "Shard.h"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Worms {
+    namespace {
+        void wake_up(int const fd) {
+            uint64_t const one = 1;
+            verify(write(fd, &one, sizeof(one)), "write eventfd");
+        }
+
+        void move_all(std::vector<InboundHeartbeat>& from, std::vector<InboundHeartbeat>& to) {
+            if (to.empty()) {
+                std::swap(from, to);
+            } else {
+                for (auto& heartbeat : from) {
+                    to.push_back(std::move(heartbeat));
+                }
+                from.clear();
+            }
+        }
+    }
+
+    int open_server_socket(uint16_t const port, bool const reuse_port,
+                           unsigned const multicast_interface) {
+        int const sock = socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock < 0)
+            syserr(errno, "opening socket");
+
+        if (reuse_port) {
+            int const enable = 1;
+            verify(setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)),
+                   "setsockopt SO_REUSEPORT");
+        }
+
+        struct sockaddr_in6 server_address{};
+        server_address.sin6_family = AF_INET6;
+        server_address.sin6_addr = in6addr_any;
+        server_address.sin6_port = htobe16(port);
+
+        verify(bind(sock, (struct sockaddr *) &server_address,
+                    sizeof(server_address)), "bind");
+
+        if (multicast_interface != 0)
+            set_multicast_interface(sock, multicast_interface);
+
+        verify(fcntl(sock, F_SETFL, O_NONBLOCK), "fcntl");
+        return sock;
+    }
+
+    Inbox::Inbox() : wakeup{eventfd(0, EFD_NONBLOCK)} {
+        if (wakeup < 0)
+            syserr(errno, "opening eventfd");
+    }
+
+    Inbox::~Inbox() {
+        close(wakeup);
+    }
+
+    void Inbox::post(std::vector<InboundHeartbeat>& batch) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            was_empty = heartbeats.empty();
+            move_all(batch, heartbeats);
+        }
+        // Otherwise the game thread has not taken previous heartbeats yet, so it is awake.
+        if (was_empty)
+            wake_up(wakeup);
+    }
+
+    void Inbox::take(std::vector<InboundHeartbeat>& batch) {
+        assert(batch.empty());
+        uint64_t posts;
+        if (read(wakeup, &posts, sizeof(posts)) == -1 && errno != EAGAIN)
+            syserr(errno, "read eventfd");
+        std::lock_guard<std::mutex> lock{mutex};
+        std::swap(batch, heartbeats);
+    }
+
+    Shard::Shard(uint16_t const port, Reactor::Backend const backend, Inbox& inbox,
+                 size_t const queue_capacity, unsigned const multicast_interface)
+            : sock{open_server_socket(port, true, multicast_interface)},
+              wakeup{eventfd(0, EFD_NONBLOCK)},
+              reactor{make_reactor(backend, wakeup, true)},
+              inbox{inbox},
+              receive_ring{sock, RECEIVE_BATCH},
+              batch_sender{sock},
+              send_queue{SendQueue::DEFAULT_CAPACITY, queue_capacity},
+              outbox{SendQueue::DEFAULT_CAPACITY, queue_capacity} {
+        if (wakeup < 0)
+            syserr(errno, "opening eventfd");
+
+        reactor->add_fd(sock);
+        reactor->watch_fd_for_input(wakeup);
+        reactor->watch_for_datagrams(receive_ring);
+    }
+
+    Shard::~Shard() {
+        // The worker may be waiting in its reactor or receiving, so it has to stop
+        // before the descriptors it uses are closed, and their numbers reused.
+        if (thread.joinable()) {
+            stopping.store(true, std::memory_order_release);
+            wake_up(wakeup);
+            thread.join();
+        }
+        close(sock);
+        close(wakeup);
+    }
+
+    void Shard::start() {
+        assert(!thread.joinable());
+        thread = std::thread{&Shard::run, this};
+    }
+
+    void Shard::post(SendQueue& queue) {
+        if (queue.empty())
+            return;
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock{outbox_mutex};
+            was_empty = outbox.empty();
+            queue.move_to(outbox);
+        }
+        if (was_empty)
+            wake_up(wakeup);
+    }
+
+    void Shard::take_egress(Stats& stats) {
+        stats.datagrams_sent += datagrams_sent.exchange(0, std::memory_order_relaxed);
+        stats.send_syscalls += send_syscalls.exchange(0, std::memory_order_relaxed);
+        stats.dropped_datagrams += datagrams_dropped.exchange(0, std::memory_order_relaxed);
+        stats.dropped_live_datagrams += live_datagrams_dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    bool Shard::drain_queue() {
+        bool const drained = reactor->send(batch_sender, send_queue);
+        datagrams_sent.fetch_add(batch_sender.datagrams_sent, std::memory_order_relaxed);
+        send_syscalls.fetch_add(batch_sender.syscalls, std::memory_order_relaxed);
+        batch_sender.datagrams_sent = batch_sender.syscalls = 0;
+        count_drops(send_queue);
+        return drained;
+    }
+
+    void Shard::count_drops(SendQueue& queue) {
+        SendQueue::Counters const counters = queue.take_counters();
+        datagrams_dropped.fetch_add(counters.dropped, std::memory_order_relaxed);
+        live_datagrams_dropped.fetch_add(counters.dropped_live, std::memory_order_relaxed);
+    }
+
+    void Shard::handle_heartbeats() {
+        // The reactor is edge-triggered, so the socket has to be drained completely.
+        size_t received;
+        do {
+            received = reactor->receive(receive_ring);
+            for (size_t i = 0; i < received; ++i) {
+                auto& buff = receive_ring.slot(i);
+                try {
+                    ClientHeartbeat heartbeat{buff};
+                    if (heartbeat.has_valid_player_name())
+                        parsed.push_back(InboundHeartbeat{receive_ring.sender(i),
+                                                          std::move(heartbeat)});
+                } catch (BadData const&) {
+                    // Ignore invalid heartbeat.
+                    buff.discard();
+                }
+            }
+        } while (received == receive_ring.capacity());
+
+        if (!parsed.empty())
+            inbox.post(parsed);
+    }
+
+    void Shard::run() {
+        while (!stopping.load(std::memory_order_acquire)) {
+            for (auto const& event : reactor->wait()) {
+                if (event.data.fd == wakeup) {
+                    if (reactor->timer_expirations() > 0) {
+                        std::lock_guard<std::mutex> lock{outbox_mutex};
+                        outbox.move_to(send_queue);
+                        count_drops(outbox);
+                    }
+                    if (!drain_queue())
+                        reactor->watch_fd_for_output(sock);
+                    continue;
+                }
+                if (event.events & EPOLLOUT) {
+                    if (drain_queue())
+                        reactor->stop_watching_fd_for_output(sock);
+                }
+                if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    handle_heartbeats();
+                }
+            }
+        }
+    }
+}
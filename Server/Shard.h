@@ -0,0 +1,113 @@
+#ifndef ROBAKI_SHARD_H
+#define ROBAKI_SHARD_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../Common/Buffer.h"
+#include "../Common/ClientHeartbeat.h"
+#include "../Common/Multicast.h"
+#include "../Common/Reactor.h"
+#include "Stats.h"
+
+namespace Worms {
+    /* Opens a non-blocking UDP socket bound to the given port on all addresses.
+     * With reuse_port, several such sockets may be bound and the kernel spreads
+     * clients among them (consistently, by their addresses).
+     * Multicast datagrams leave by the given interface, unless it is 0. */
+    int open_server_socket(uint16_t port, bool reuse_port, unsigned multicast_interface = 0);
+
+    /* Interface of the group, if there is a group and it names one, or 0. */
+    inline unsigned multicast_interface(std::optional<sockaddr_in6> const& group) {
+        return group.has_value() ? group->sin6_scope_id : 0;
+    }
+
+    /* Heartbeat already parsed and validated by a shard. */
+    struct InboundHeartbeat {
+        sockaddr_in6 sender;
+        ClientHeartbeat heartbeat;
+    };
+
+    /* Heartbeats handed over from shards to the game thread.
+     * The game thread is woken up through an eventfd whenever the inbox becomes nonempty. */
+    class Inbox {
+    private:
+        int const wakeup;
+        std::mutex mutex;
+        std::vector<InboundHeartbeat> heartbeats;
+
+    public:
+        Inbox();
+
+        ~Inbox();
+
+        [[nodiscard]] int fd() const {
+            return wakeup;
+        }
+
+        /* Moves all heartbeats out of batch into the inbox. */
+        void post(std::vector<InboundHeartbeat>& batch);
+
+        /* Moves all heartbeats out of the inbox into batch, which must be empty. */
+        void take(std::vector<InboundHeartbeat>& batch);
+    };
+
+    /* Worker thread owning one of SO_REUSEPORT sockets of the server.
+     * It parses heartbeats of its clients for the game thread and sends them
+     * the datagrams that the game thread posts to its outbox. */
+    class Shard {
+    private:
+        static constexpr size_t const RECEIVE_BATCH = 64;
+
+        int const sock;
+        // The outbox's eventfd takes the place of the reactor's timer,
+        // as both are read the same way: as a counter of 8 bytes.
+        int const wakeup;
+        std::unique_ptr<Reactor> reactor;
+        Inbox& inbox;
+        UDPReceiveRing receive_ring;
+        UDPBatchSender batch_sender;
+        SendQueue send_queue;
+        std::vector<InboundHeartbeat> parsed;
+
+        std::mutex outbox_mutex;
+        SendQueue outbox;
+
+        std::atomic<uint64_t> datagrams_sent{0};
+        std::atomic<uint64_t> send_syscalls{0};
+        std::atomic<uint64_t> datagrams_dropped{0};
+        std::atomic<uint64_t> live_datagrams_dropped{0};
+
+        std::atomic<bool> stopping{false};
+        std::thread thread;
+
+    public:
+        Shard(uint16_t port, Reactor::Backend backend, Inbox& inbox, size_t queue_capacity,
+              unsigned multicast_interface);
+
+        ~Shard();
+
+        /* Starts the worker thread, which runs until the shard is destroyed. */
+        void start();
+
+        /* Moves all datagrams out of queue into the outbox, to be sent by the worker. */
+        void post(SendQueue& queue);
+
+        /* Moves counters of datagrams sent (or dropped) so far into stats. */
+        void take_egress(Stats& stats);
+
+    private:
+        void run();
+
+        bool drain_queue();
+
+        /* Adds datagrams dropped by queue so far to those reported by take_egress(). */
+        void count_drops(SendQueue& queue);
+
+        void handle_heartbeats();
+    };
+}
+
+#endif //ROBAKI_SHARD_H
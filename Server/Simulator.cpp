@@ -0,0 +1,152 @@
+#include "Simulator.h"
+
+#include <ctime>
+
+#include <algorithm>
+
+#include "../Common/ClientHeartbeat.h"
+#include "../Common/Multicast.h"
+#include "../Common/err.h"
+
+namespace Worms {
+    namespace {
+        uint64_t now_ns() {
+            struct timespec spec{};
+            verify(clock_gettime(CLOCK_MONOTONIC, &spec), "clock_gettime");
+            return static_cast<uint64_t>(spec.tv_sec) * 1'000'000'000 + spec.tv_nsec;
+        }
+
+        std::vector<std::string> split_words(std::string const& line) {
+            std::vector<std::string> words;
+            size_t pos = 0;
+            while ((pos = line.find_first_not_of(" \t", pos)) != std::string::npos) {
+                size_t const end = line.find_first_of(" \t", pos);
+                words.push_back(line.substr(pos, end - pos));
+                pos = end;
+            }
+            return words;
+        }
+    }
+
+    Script Script::read(FILE* const file) {
+        Script script;
+        char* line = nullptr;
+        size_t capacity = 0;
+        ssize_t len;
+        bool first = true;
+        while ((len = getline(&line, &capacity, file)) != -1) {
+            std::string text{line, static_cast<size_t>(len)};
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+                text.pop_back();
+
+            if (first) {
+                first = false;
+                script.players = split_words(text);
+                continue;
+            }
+            if (text.size() != script.players.size())
+                fatal("Script round %zu: a letter per player expected", script.rounds.size());
+            auto& round = script.rounds.emplace_back();
+            for (char const letter : text) {
+                switch (letter) {
+                    case 'S':
+                        round.push_back(STRAIGHT);
+                        break;
+                    case 'R':
+                        round.push_back(RIGHT);
+                        break;
+                    case 'L':
+                        round.push_back(LEFT);
+                        break;
+                    default:
+                        fatal("Script round %zu: unknown direction '%c'",
+                              script.rounds.size() - 1, letter);
+                }
+            }
+        }
+        free(line);
+
+        auto sorted = script.players;
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.size() < 2 || sorted.size() > UINT8_MAX)
+            fatal("Script: between 2 and %u players expected", UINT8_MAX);
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+            fatal("Script: player names must be distinct");
+        for (auto const& name : sorted) {
+            if (!ClientHeartbeat::is_valid_name(name) || name.empty())
+                fatal("Script: invalid player name '%s'", name.c_str());
+        }
+        return script;
+    }
+
+    Script Script::bots(size_t const num) {
+        Script script;
+        for (size_t i = 0; i < num; ++i) {
+            script.players.push_back("bot" + std::to_string(i));
+        }
+        return script;
+    }
+
+    SimulationResult simulate(GameConstants const& constants, uint32_t const seed,
+                              Script const& script, uint64_t const max_rounds,
+                              Audience const& audience) {
+        RandomGenerator rand{seed};
+        Board board{constants};
+        GameArena arena;
+
+        // Players need clients, if only to be told apart; addresses differ by port.
+        ClientSlots clients;
+        std::vector<ClientHandle> players;
+        for (size_t i = 0; i < script.players.size(); ++i) {
+            sockaddr_in6 address{};
+            address.sin6_family = AF_INET6;
+            address.sin6_port = htobe16(static_cast<uint16_t>(i + 1));
+            Player player{script.players[i], STRAIGHT};
+            player.got_ready();
+            players.push_back(clients.insert(ClientData{address, 0, 0, std::move(player)}));
+        }
+        for (size_t i = 0; i < audience.observers; ++i) {
+            sockaddr_in6 address{};
+            address.sin6_family = AF_INET6;
+            address.sin6_port = htobe16(static_cast<uint16_t>(players.size() + i + 1));
+            clients.insert(ClientData{address, 0, 0, Player{"", STRAIGHT}});
+        }
+        std::optional<sockaddr_in6> const group =
+                audience.multicast ? parse_multicast_group("ff15::4242", 2022) : std::nullopt;
+        SendQueue egress;
+
+        Game game{constants, board, arena, rand, clients};
+
+        SimulationResult result{seed, game.id(), 0, 0, {}, {}, 0, 0};
+        while (!game.finished() && result.rounds < max_rounds) {
+            if (script.rounds.empty()) {
+                // A bot keeps turning the same way for 16 rounds on average.
+                for (ClientHandle const player : players) {
+                    if (rand() % 16 == 0)
+                        clients.get(player)->player.turn_direction = rand() % 3;
+                }
+            } else {
+                auto const& round = script.rounds[std::min<size_t>(result.rounds,
+                                                                   script.rounds.size() - 1)];
+                for (size_t i = 0; i < players.size(); ++i) {
+                    clients.get(players[i])->player.turn_direction = round[i];
+                }
+            }
+
+            uint64_t const start = now_ns();
+            game.play_round();
+            result.round_ns.push_back(now_ns() - start);
+            ++result.rounds;
+
+            game.disseminate_new_events(egress, group.has_value() ? &*group : nullptr);
+            result.egress_datagrams += egress.size();
+            for (; !egress.empty(); egress.pop_front()) {
+                result.egress_bytes += egress[0].size();
+            }
+        }
+
+        result.events = game.events().size();
+        game.events().dump(result.log);
+        return result;
+    }
+}
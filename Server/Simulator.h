@@ -0,0 +1,60 @@
+#ifndef ROBAKI_SIMULATOR_H
+#define ROBAKI_SIMULATOR_H
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "Game.h"
+#include "GameConstants.h"
+
+namespace Worms {
+    /* Turn directions of players of a simulated game, round by round. */
+    struct Script {
+        std::vector<std::string> players;
+        // Turn direction of each player (in the order above) in consecutive rounds;
+        // the last round repeats until the game ends. With no rounds at all,
+        // players are bots, which turn at random.
+        std::vector<std::vector<uint8_t>> rounds;
+
+        /* Reads player names from the first line, then a line per round with a letter
+         * per player: S (straight), R (right) or L (left). Fails with fatal(). */
+        static Script read(FILE* file);
+
+        /* Script of num bots, named bot0, bot1 and so on. */
+        static Script bots(size_t num);
+    };
+
+    struct SimulationResult {
+        uint32_t seed;
+        uint32_t game_id;
+        uint64_t rounds;
+        size_t events;
+        // Game's events, as they are sent: game_id followed by events in wire format.
+        std::string log;
+        std::vector<uint64_t> round_ns;
+        // Datagrams that would be sent to players and observers, live ones only.
+        uint64_t egress_datagrams;
+        uint64_t egress_bytes;
+    };
+
+    /* Spectators of a simulated game, who receive its events, either each on its own
+     * or, with multicast, through a single copy published to a group. */
+    struct Audience {
+        size_t observers = 0;
+        bool multicast = false;
+    };
+
+    /* Runs a game, from the first heartbeat of its players on, as fast as it goes,
+     * without any clients or sockets. The game is seeded with seed, as the first game
+     * of a server would be, and bots draw from it as well, so the result (apart from
+     * timings) depends on nothing else. Stops after max_rounds, even if unfinished.
+     * Events are disseminated after every round, as the server would, to measure egress;
+     * datagrams are counted and dropped. */
+    SimulationResult simulate(GameConstants const& constants, uint32_t seed,
+                              Script const& script, uint64_t max_rounds,
+                              Audience const& audience = {});
+}
+
+#endif //ROBAKI_SIMULATOR_H
@@ -0,0 +1,125 @@
+#ifndef ROBAKI_SLOTMAP_H
+#define ROBAKI_SLOTMAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+namespace Worms {
+    /* Values referred to by handles, which stay valid as long as their values exist
+     * and are recognized as stale afterwards, as every slot counts its reuses.
+     * Values themselves are kept dense, in no particular order, so that iterating
+     * over them is a walk through a single array. */
+    template<typename T>
+    class SlotMap {
+    public:
+        struct Handle {
+            uint32_t index = UINT32_MAX;
+            uint32_t generation = 0;
+
+            bool operator==(Handle const& other) const {
+                return index == other.index && generation == other.generation;
+            }
+        };
+
+    private:
+        struct Slot {
+            uint32_t dense;
+            uint32_t generation;
+        };
+
+        std::vector<T> values;
+        // Slot of every value, so that the last one can be moved into a hole.
+        std::vector<uint32_t> owners;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> free_slots;
+
+    public:
+        [[nodiscard]] size_t size() const {
+            return values.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return values.empty();
+        }
+
+        Handle insert(T value) {
+            uint32_t index;
+            if (free_slots.empty()) {
+                index = static_cast<uint32_t>(slots.size());
+                slots.push_back(Slot{0, 0});
+            } else {
+                index = free_slots.back();
+                free_slots.pop_back();
+            }
+            slots[index].dense = static_cast<uint32_t>(values.size());
+            values.push_back(std::move(value));
+            owners.push_back(index);
+            return Handle{index, slots[index].generation};
+        }
+
+        /* Returns the value, or nullptr if the handle is stale. */
+        [[nodiscard]] T* get(Handle const handle) {
+            if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+                return nullptr;
+            return &values[slots[handle.index].dense];
+        }
+
+        [[nodiscard]] T const* get(Handle const handle) const {
+            return const_cast<SlotMap*>(this)->get(handle);
+        }
+
+        /* Returns false if the handle was stale already. */
+        bool erase(Handle const handle) {
+            if (get(handle) == nullptr)
+                return false;
+            Slot& slot = slots[handle.index];
+            uint32_t const last = static_cast<uint32_t>(values.size() - 1);
+            if (slot.dense != last) {
+                values[slot.dense] = std::move(values[last]);
+                owners[slot.dense] = owners[last];
+                slots[owners[last]].dense = slot.dense;
+            }
+            values.pop_back();
+            owners.pop_back();
+            ++slot.generation;
+            free_slots.push_back(handle.index);
+            return true;
+        }
+
+        /* Handle of the i-th value in the dense order. */
+        [[nodiscard]] Handle handle_at(size_t const i) const {
+            assert(i < values.size());
+            return Handle{owners[i], slots[owners[i]].generation};
+        }
+
+        T& operator[](size_t const i) {
+            return values[i];
+        }
+
+        T const& operator[](size_t const i) const {
+            return values[i];
+        }
+
+        typename std::vector<T>::iterator begin() {
+            return values.begin();
+        }
+
+        typename std::vector<T>::iterator end() {
+            return values.end();
+        }
+
+        typename std::vector<T>::const_iterator begin() const {
+            return values.begin();
+        }
+
+        typename std::vector<T>::const_iterator end() const {
+            return values.end();
+        }
+    };
+}
+
+#endif //ROBAKI_SLOTMAP_H
@@ -0,0 +1,81 @@
+#ifndef ROBAKI_STATS_H
+#define ROBAKI_STATS_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+
+#include "../Common/Buffer.h"
+
+namespace Worms {
+    /* Counters of server's network activity during a single game.
+     * They are always maintained, yet reported only in builds with WORMS_STATS defined. */
+    struct Stats {
+        uint64_t rounds = 0;
+        // Rounds which took the server longer than the round lasts, for all rooms together.
+        uint64_t late_rounds = 0;
+        // Ticks that found rounds overdue, the most rounds overdue at once,
+        // and those skipped for exceeding the limit of rounds played at once.
+        uint64_t lagging_ticks = 0;
+        uint64_t max_tick_lag = 0;
+        uint64_t skipped_rounds = 0;
+        uint64_t datagrams_sent = 0;
+        uint64_t send_syscalls = 0;
+        // Catch-ups cut short by a client's send budget and continued in later rounds.
+        uint64_t deferred_catch_ups = 0;
+        // Pending catch-ups abandoned, as their client left or a new game started.
+        uint64_t dropped_catch_ups = 0;
+        // Datagrams enqueued, by kind, and those dropped when a send queue got full:
+        // catch-up ones, and live ones once the queue could not grow any more.
+        uint64_t live_datagrams = 0;
+        uint64_t catch_up_datagrams = 0;
+        uint64_t dropped_datagrams = 0;
+        uint64_t dropped_live_datagrams = 0;
+        size_t queue_high_water = 0;
+        // Memory taken by the game from its arena.
+        uint64_t arena_bytes = 0;
+        uint64_t arena_allocations = 0;
+
+        void report([[maybe_unused]] uint32_t game_id) const {
+#ifdef WORMS_STATS
+            double const per_round = rounds == 0 ? 0.0 : static_cast<double>(send_syscalls) /
+                                                         static_cast<double>(rounds);
+            fprintf(stderr, "game %u: %lu rounds (%lu late), %lu datagrams sent in %lu syscalls "
+                            "(%.2f syscalls per round), %lu catch-ups deferred, %lu dropped\n",
+                    game_id, rounds, late_rounds, datagrams_sent, send_syscalls, per_round,
+                    deferred_catch_ups, dropped_catch_ups);
+            fprintf(stderr, "game %u: %lu live and %lu catch-up datagrams enqueued, "
+                            "%lu dropped (%lu live), at most %zu queued at once\n",
+                    game_id, live_datagrams, catch_up_datagrams, dropped_datagrams,
+                    dropped_live_datagrams, queue_high_water);
+            fprintf(stderr, "game %u: %lu ticks lagging, by at most %lu rounds, "
+                            "%lu rounds skipped\n",
+                    game_id, lagging_ticks, max_tick_lag, skipped_rounds);
+            fprintf(stderr, "game %u: %lu bytes in %lu allocations from its arena\n",
+                    game_id, arena_bytes, arena_allocations);
+#endif
+        }
+
+        /* Moves sender's counters gathered so far into these statistics. */
+        void take_egress(UDPBatchSender& sender) {
+            datagrams_sent += sender.datagrams_sent;
+            send_syscalls += sender.syscalls;
+            sender.datagrams_sent = sender.syscalls = 0;
+        }
+
+        void take_queue_counters(SendQueue::Counters const& counters) {
+            live_datagrams += counters.live;
+            catch_up_datagrams += counters.catch_up;
+            dropped_datagrams += counters.dropped;
+            dropped_live_datagrams += counters.dropped_live;
+            queue_high_water = std::max(queue_high_water, counters.high_water);
+        }
+
+        void reset() {
+            *this = Stats{};
+        }
+    };
+}
+
+#endif //ROBAKI_STATS_H
@@ -0,0 +1,129 @@
+#ifndef ROBAKI_TIMERWHEEL_H
+#define ROBAKI_TIMERWHEEL_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
+
+namespace Worms {
+    /* Hashed timing wheel with a bucket per round: timers due in a round are linked
+     * into the bucket of their round number, modulo the wheel's size. Arming, re-arming
+     * and cancelling a timer take constant time, and expiring visits only the buckets
+     * of rounds passed, so its cost does not depend on the number of timers.
+     * Deadlines further away than the wheel's size work, but are passed over
+     * by sweeps of their bucket until they come. */
+    template<typename Key>
+    class TimerWheel {
+    public:
+        using Timer = uint32_t;
+
+    private:
+        static constexpr uint32_t const NONE = UINT32_MAX;
+
+        struct Node {
+            Key key;
+            uint64_t deadline;
+            uint32_t prev;
+            uint32_t next;
+            bool linked;
+        };
+
+        std::vector<uint32_t> buckets;
+        std::vector<Node> nodes;
+        std::vector<Timer> free_nodes;
+        uint64_t swept_round_no = 0;
+
+        [[nodiscard]] uint32_t& bucket(uint64_t const round_no) {
+            return buckets[round_no & (buckets.size() - 1)];
+        }
+
+        void link(Timer const timer) {
+            Node& node = nodes[timer];
+            uint32_t& head = bucket(node.deadline);
+            node.prev = NONE;
+            node.next = head;
+            if (head != NONE)
+                nodes[head].prev = timer;
+            head = timer;
+            node.linked = true;
+        }
+
+        void unlink(Timer const timer) {
+            Node& node = nodes[timer];
+            if (!node.linked)
+                return;
+            if (node.prev != NONE)
+                nodes[node.prev].next = node.next;
+            else
+                bucket(node.deadline) = node.next;
+            if (node.next != NONE)
+                nodes[node.next].prev = node.prev;
+            node.linked = false;
+        }
+
+    public:
+        /* Deadlines are expected to be at most horizon rounds ahead. */
+        explicit TimerWheel(uint64_t const horizon) {
+            size_t size = 1;
+            while (size <= horizon) {
+                size <<= 1;
+            }
+            buckets.assign(size, NONE);
+        }
+
+        Timer arm(Key key, uint64_t const deadline) {
+            Timer timer;
+            if (free_nodes.empty()) {
+                timer = static_cast<Timer>(nodes.size());
+                nodes.push_back(Node{std::move(key), deadline, NONE, NONE, false});
+            } else {
+                timer = free_nodes.back();
+                free_nodes.pop_back();
+                nodes[timer] = Node{std::move(key), deadline, NONE, NONE, false};
+            }
+            link(timer);
+            return timer;
+        }
+
+        void rearm(Timer const timer, uint64_t const deadline) {
+            if (nodes[timer].linked && nodes[timer].deadline == deadline)
+                return;
+            unlink(timer);
+            nodes[timer].deadline = deadline;
+            link(timer);
+        }
+
+        /* Releases the timer, whether it has expired or not. */
+        void cancel(Timer const timer) {
+            unlink(timer);
+            free_nodes.push_back(timer);
+        }
+
+        /* Appends keys of timers due by round_no to expired. Expired timers stay
+         * allocated, yet not armed, until cancelled or re-armed. */
+        void expire(uint64_t const round_no, std::vector<Key>& expired) {
+            if (round_no <= swept_round_no)
+                return;
+            uint64_t const from = std::max(swept_round_no + 1,
+                                           round_no >= buckets.size()
+                                           ? round_no - buckets.size() + 1 : 0);
+            for (uint64_t r = from; r <= round_no; ++r) {
+                uint32_t timer = bucket(r);
+                while (timer != NONE) {
+                    uint32_t const next = nodes[timer].next;
+                    if (nodes[timer].deadline <= round_no) {
+                        unlink(timer);
+                        expired.push_back(nodes[timer].key);
+                    }
+                    timer = next;
+                }
+            }
+            swept_round_no = round_no;
+        }
+    };
+}
+
+#endif //ROBAKI_TIMERWHEEL_H
@@ -0,0 +1,155 @@
+#include <getopt.h>
+#include "cerrno"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "../Server/Board.h"
+#include "../Server/RandomGenerator.h"
+
+static constexpr uint32_t const SIDES[][2] = {
+        {640, 480}, {1920, 1080}, {4096, 4096}, {8192, 8192}, {16384, 16384},
+};
+static constexpr uint32_t const TURNING_SPEED = 6;
+// Pixels eaten on a board before it is cleared for the next game.
+static constexpr size_t const PIXELS_PER_GAME = 1 << 16;
+static constexpr unsigned const REPETITIONS = 5;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point const start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /* Pixels entered by worms moving the way they do in games, turning at random.
+     * Worms leaving the board are respawned; collisions are left to the board. */
+    std::vector<Worms::Pixel> trace(Worms::GameConstants const& constants, size_t const worms_num,
+                                    uint64_t const rounds, uint32_t const seed) {
+        struct Worm {
+            Worms::Position position;
+            Worms::angle_t angle;
+        };
+        Worms::RandomGenerator rand{seed};
+        auto const spawn = [&] {
+            return Worm{Worms::Position{rand() % constants.width + 0.5,
+                                        rand() % constants.height + 0.5},
+                        Worms::angle_t{static_cast<uint16_t>(rand())}};
+        };
+
+        std::vector<Worm> worms;
+        std::vector<Worms::Pixel> pixels;
+        for (size_t i = 0; i < worms_num; ++i) {
+            worms.push_back(spawn());
+            pixels.push_back(worms.back().position.as_pixel());
+        }
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (auto& worm : worms) {
+                uint32_t const turn = rand() % 3;
+                if (turn == Worms::RIGHT)
+                    worm.angle += constants.turning_speed;
+                else if (turn == Worms::LEFT)
+                    worm.angle -= constants.turning_speed;
+                Worms::Pixel const before = worm.position.as_pixel();
+                worm.position.move_with_angle(worm.angle);
+                Worms::Pixel const after = worm.position.as_pixel();
+                if (after == before)
+                    continue;
+                if (!after.on_board(constants.width, constants.height))
+                    worm = spawn();
+                pixels.push_back(worm.position.as_pixel());
+            }
+        }
+        return pixels;
+    }
+
+    struct Timing {
+        double construction;
+        double playing;
+        uint64_t collisions;
+    };
+
+    template<typename Board>
+    Timing time_once(Worms::GameConstants const& constants, std::vector<Worms::Pixel> const& pixels) {
+        auto const start = Clock::now();
+        Board board{constants};
+        Timing timing{seconds_since(start), 0, 0};
+
+        // Every pixel is eaten, unless it has been already, as in games.
+        // The board is cleared every PIXELS_PER_GAME pixels, as if for the next game.
+        auto const play_start = Clock::now();
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            if (i % PIXELS_PER_GAME == 0)
+                board.clear();
+            if (!board.try_eat(pixels[i]))
+                ++timing.collisions;
+        }
+        timing.playing = seconds_since(play_start);
+        return timing;
+    }
+
+    /* Reports the best of REPETITIONS runs, as the others were disturbed by something else. */
+    template<typename Board>
+    void measure(char const *name, Worms::GameConstants const& constants,
+                 std::vector<Worms::Pixel> const& pixels) {
+        Timing best = time_once<Board>(constants, pixels);
+        for (unsigned i = 1; i < REPETITIONS; ++i) {
+            Timing const timing = time_once<Board>(constants, pixels);
+            best.construction = std::min(best.construction, timing.construction);
+            best.playing = std::min(best.playing, timing.playing);
+        }
+        printf("%5ux%-5u %-9s: constructed in %8.3f ms, %6.1f M pixels checked per second"
+               " (%lu collisions)\n",
+               constants.width, constants.height, name, best.construction * 1e3,
+               pixels.size() / best.playing / 1e6, best.collisions);
+    }
+}
+
+/* Compares bitmaps of eaten pixels: dense ones in both layouts, the sparse one and
+ * Board, which picks between them, on boards from 640x480 up to 16384x16384.
+ * Construction includes allocating and zeroing the whole bitmap. Collision checks
+ * replay a trace of worms moving as in games, so their locality is that of real ones,
+ * while the cost of moving them is left out. */
+int main(int argc, char *argv[]) {
+    int opt;
+    unsigned long worms_num = 8;
+    uint64_t rounds = 1 << 20;
+    unsigned long parsed_arg;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        if (opt == '?')
+            goto bad_syntax;
+        errno = 0;
+        char *badchar;
+        parsed_arg = strtoul(optarg, &badchar, 10);
+        if (*badchar != '\0' || errno != 0 || parsed_arg == 0)
+            goto bad_syntax;
+        switch (opt) {
+            case 'n':
+                if (parsed_arg > UINT8_MAX)
+                    goto bad_syntax;
+                worms_num = parsed_arg;
+                break;
+            case 'r':
+                rounds = parsed_arg;
+                break;
+            default:
+                goto bad_syntax;
+        }
+    }
+    if (optind != argc) {
+        bad_syntax:
+        fprintf(stderr, "Usage: %s [-n worms] [-r rounds]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (auto const& [width, height] : SIDES) {
+        Worms::GameConstants const constants{TURNING_SPEED, 1, width, height};
+        auto const pixels = trace(constants, worms_num, rounds, 1);
+        measure<Worms::BasicBoard<Worms::RowMajorLayout>>("row-major", constants, pixels);
+        measure<Worms::BasicBoard<Worms::TiledLayout>>("tiled", constants, pixels);
+        measure<Worms::SparseBoard>("sparse", constants, pixels);
+        measure<Worms::Board>("board", constants, pixels);
+    }
+}
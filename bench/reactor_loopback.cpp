@@ -0,0 +1,193 @@
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include "cerrno"
+
+#include <chrono>
+#include <memory>
+
+#include "../Common/Reactor.h"
+
+// Datagrams the receiving ring takes in a single call, as in the server.
+static constexpr size_t const RECEIVE_BATCH = 64;
+static constexpr unsigned long const MAX_WINDOW = 1 << 16;
+
+namespace {
+    /* Socket bound to an ephemeral port of the IPv6 loopback, sending to itself. */
+    int open_loopback_socket(sockaddr_in6& address) {
+        int const sock = socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock < 0)
+            syserr(errno, "opening socket");
+
+        // Room for the whole window, so that the receiving side does not drop datagrams.
+        int const buffer_size = 16 << 20;
+        verify(setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size)),
+               "setsockopt SO_RCVBUF");
+
+        address = sockaddr_in6{};
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_loopback;
+        verify(bind(sock, (struct sockaddr *) &address, sizeof(address)), "bind");
+        socklen_t len = sizeof(address);
+        verify(getsockname(sock, (struct sockaddr *) &address, &len), "getsockname");
+
+        verify(fcntl(sock, F_SETFL, O_NONBLOCK), "fcntl");
+        return sock;
+    }
+
+    struct Result {
+        uint64_t received = 0;
+        uint64_t lost = 0;
+        double seconds = 0;
+        double cpu_seconds = 0;
+        long context_switches = 0;
+        uint64_t send_submissions = 0;
+    };
+
+    double cpu_seconds(rusage const& usage) {
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+               + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    /* Pushes `total` datagrams of given size through the reactor, keeping at most
+     * `window` of them in flight, and receives them back on the same socket. */
+    Result run(Worms::Reactor::Backend const backend, uint64_t const total,
+               size_t const window, uint16_t const size) {
+        sockaddr_in6 address{};
+        int const sock = open_loopback_socket(address);
+        int const timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (timer < 0)
+            syserr(errno, "timerfd_create");
+        // Ticks detect datagrams lost on the way, which would otherwise stall the window.
+        itimerspec const tick{{0, 100'000'000}, {0, 100'000'000}};
+        verify(timerfd_settime(timer, 0, &tick, nullptr), "timerfd_settime");
+
+        auto reactor = Worms::make_reactor(backend, timer, true);
+        Worms::UDPReceiveRing ring{sock, RECEIVE_BATCH};
+        Worms::UDPBatchSender sender{sock};
+        Worms::SendQueue queue{window};
+        reactor->watch_fd_for_input(timer);
+        reactor->add_fd(sock);
+        reactor->watch_for_datagrams(ring);
+
+        std::shared_ptr<char const> const payload{new char[size](), std::default_delete<char[]>{}};
+        uint64_t enqueued = 0;
+        Result result;
+        uint64_t received_at_tick = 0;
+        bool clogged = false;
+
+        auto const refill = [&] {
+            while (enqueued < total && enqueued < result.received + result.lost + window) {
+                queue.push_back(Worms::QueuedDatagram{address, payload, nullptr, 0,
+                                                      payload.get(), size, true});
+                ++enqueued;
+            }
+            if (!clogged && !queue.empty() && !reactor->send(sender, queue)) {
+                clogged = true;
+                reactor->watch_fd_for_output(sock);
+            }
+        };
+
+        rusage usage_before{};
+        verify(getrusage(RUSAGE_SELF, &usage_before), "getrusage");
+        auto const start = std::chrono::steady_clock::now();
+
+        refill();
+        while (result.received + result.lost < total) {
+            for (auto const& event : reactor->wait()) {
+                if (event.data.fd == timer) {
+                    if (reactor->timer_expirations() > 0) {
+                        if (result.received == received_at_tick && !clogged && queue.empty())
+                            result.lost = enqueued - result.received;
+                        received_at_tick = result.received;
+                    }
+                    continue;
+                }
+                if ((event.events & EPOLLOUT) && reactor->send(sender, queue)) {
+                    clogged = false;
+                    reactor->stop_watching_fd_for_output(sock);
+                }
+                if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    size_t received;
+                    do {
+                        received = reactor->receive(ring);
+                        for (size_t i = 0; i < received; ++i) {
+                            ring.slot(i).discard();
+                        }
+                        result.received += received;
+                    } while (received == ring.capacity());
+                }
+            }
+            refill();
+        }
+
+        auto const stop = std::chrono::steady_clock::now();
+        rusage usage_after{};
+        verify(getrusage(RUSAGE_SELF, &usage_after), "getrusage");
+
+        result.seconds = std::chrono::duration<double>(stop - start).count();
+        result.cpu_seconds = cpu_seconds(usage_after) - cpu_seconds(usage_before);
+        result.context_switches = (usage_after.ru_nvcsw + usage_after.ru_nivcsw)
+                                  - (usage_before.ru_nvcsw + usage_before.ru_nivcsw);
+        result.send_submissions = sender.syscalls;
+
+        reactor.reset();
+        close(timer);
+        close(sock);
+        return result;
+    }
+}
+
+/* Compares reactor backends on a loopback round trip: datagrams are queued, sent
+ * with the backend's send() and received back with its receive(), just like the
+ * server's egress and ingress, but without the game in between. */
+int main(int argc, char *argv[]) {
+    int opt;
+    uint64_t total = 1'000'000;
+    unsigned long window = 4096;
+    unsigned long size = 100;
+    unsigned long parsed_arg;
+
+    while ((opt = getopt(argc, argv, "n:w:s:")) != -1) {
+        if (opt == '?')
+            goto bad_syntax;
+        errno = 0;
+        char *badchar;
+        parsed_arg = strtoul(optarg, &badchar, 10);
+        if (*badchar != '\0' || errno != 0 || parsed_arg == 0)
+            goto bad_syntax;
+        switch (opt) {
+            case 'n':
+                total = parsed_arg;
+                break;
+            case 'w':
+                if (parsed_arg > MAX_WINDOW)
+                    goto bad_syntax;
+                window = parsed_arg;
+                break;
+            case 's':
+                if (parsed_arg > Worms::MAX_DATA_SIZE)
+                    goto bad_syntax;
+                size = parsed_arg;
+                break;
+            default:
+                goto bad_syntax;
+        }
+    }
+    if (optind != argc) {
+        bad_syntax:
+        fprintf(stderr, "Usage: %s [-n datagrams] [-w window] [-s size]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (char const *name : {"epoll", "io_uring"}) {
+        Result const result = run(Worms::parse_backend(name).value(), total, window,
+                                  static_cast<uint16_t>(size));
+        printf("%-8s: %lu datagrams of %lu bytes (%lu lost) in %.3f s, %.0f datagrams/s, "
+               "%.3f s of CPU, %ld context switches, %lu send submissions\n",
+               name, result.received, size, result.lost, result.seconds,
+               result.received / result.seconds, result.cpu_seconds,
+               result.context_switches, result.send_submissions);
+    }
+}
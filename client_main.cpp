@@ -1,40 +1,55 @@
 #include <getopt.h>
 
 #include "Client/Client.h"
+#include "Common/ClientHeartbeat.h"
+#include "Common/Multicast.h"
 
 int main(int argc, char *argv[]) {
     int opt;
     char const *game_server;
     char const *game_iface = "localhost";
     std::string player_name;
+    std::string room;
     uint16_t server_port = 2021;
     uint16_t iface_port = 20210;
+    Worms::Reactor::Backend backend = Worms::Reactor::Backend::EPOLL;
+    std::optional<Worms::Reactor::Backend> parsed_backend;
+    char const *multicast_spec = nullptr;
+    std::optional<uint16_t> multicast_port;
+    std::optional<sockaddr_in6> multicast_group;
     unsigned long parsed_arg;
 
     if (argc < 2) {
     bad_syntax:
         fprintf(stderr, "Usage: %s game_server [-n player_name]"
-                        " [-p n] [-i gui_server] [-r n]\n",
+                        " [-p n] [-i gui_server] [-r n] [-b epoll|io_uring] [-R room]"
+                        " [-m group[%%iface]] [-M port]\n",
                 argv[0]);
         exit(EXIT_FAILURE);
     }
 
     game_server = argv[1];
 
-    while ((opt = getopt(argc, argv, "n:p:i:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "n:p:i:r:b:R:m:M:")) != -1) {
         if (opt == '?') {
             goto bad_syntax;
         } else {
             switch (opt) {
                 case 'p':
                 case 'r':
+                case 'M':
                     parsed_arg = strtoul(optarg, nullptr, 10);
                     if (errno != 0 || parsed_arg > UINT16_MAX)
                         goto bad_syntax;
                     if (opt == 'p')
                         server_port = parsed_arg;
-                    else
+                    else if (opt == 'r')
                         iface_port = parsed_arg;
+                    else
+                        multicast_port = parsed_arg;
+                    break;
+                case 'm':
+                    multicast_spec = optarg;
                     break;
                 case 'n':
                     player_name = optarg;
@@ -42,14 +57,39 @@ int main(int argc, char *argv[]) {
                 case 'i':
                     game_iface = optarg;
                     break;
+                case 'R':
+                    room = optarg;
+                    if (!Worms::ClientHeartbeat::is_valid_name(room))
+                        goto bad_syntax;
+                    break;
+                case 'b':
+                    parsed_backend = Worms::parse_backend(optarg);
+                    if (!parsed_backend.has_value())
+                        goto bad_syntax;
+                    backend = *parsed_backend;
+                    break;
                 default:
                     goto bad_syntax;
             }
         }
     }
 
-    Worms::Client client{std::move(player_name), game_server, server_port,
-                  game_iface, iface_port};
+    // As on the server, the group's port is by default the one next to the server's.
+    // The group carries events of the default room only, which would otherwise
+    // be taken for those of another game.
+    if (multicast_spec != nullptr) {
+        if (!room.empty())
+            goto bad_syntax;
+        if (!multicast_port.has_value() && server_port == UINT16_MAX)
+            goto bad_syntax;
+        multicast_group = Worms::parse_multicast_group(
+                multicast_spec, multicast_port.value_or(server_port + 1));
+        if (!multicast_group.has_value())
+            goto bad_syntax;
+    }
+
+    Worms::Client client{std::move(player_name), std::move(room), game_server, server_port,
+                  game_iface, iface_port, backend, multicast_group};
 
     client.play();
 }
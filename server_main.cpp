@@ -1,8 +1,13 @@
 #include <getopt.h>
 #include "cerrno"
 
+#include "Common/Multicast.h"
 #include "Server/Server.h"
 
+static constexpr unsigned long const MAX_WORKERS = 256;
+static constexpr unsigned long const MAX_ROOM_THREADS = 256;
+static constexpr unsigned long const MAX_ROOMS = 1 << 16;
+
 int main(int argc, char *argv[]) {
     int opt;
     uint16_t port = 2021;
@@ -11,11 +16,27 @@ int main(int argc, char *argv[]) {
     uint32_t rounds_per_sec = 50;
     uint32_t width = 640;
     uint32_t height = 480;
+    Worms::Reactor::Backend backend = Worms::Reactor::Backend::EPOLL;
+    unsigned workers = 0;
+    size_t queue_capacity = Worms::SendQueue::MAX_CAPACITY;
+    unsigned room_threads = 1;
+    size_t max_rooms = 1024;
+    uint64_t max_catch_up_rounds = 0;
+    char const *multicast_spec = nullptr;
+    uint16_t multicast_port = 0;
+    std::optional<sockaddr_in6> multicast_group;
     unsigned long parsed_arg;
 
-    while ((opt = getopt(argc, argv, "p:s:t:v:w:h:")) != -1) {
+    while ((opt = getopt(argc, argv, "p:s:t:v:w:h:b:n:q:j:r:c:m:M:")) != -1) {
         if (opt == '?') {
             goto bad_syntax;
+        } else if (opt == 'b') {
+            auto parsed_backend = Worms::parse_backend(optarg);
+            if (!parsed_backend.has_value())
+                goto bad_syntax;
+            backend = *parsed_backend;
+        } else if (opt == 'm') {
+            multicast_spec = optarg;
         } else {
             errno = 0;
             char *badchar;
@@ -43,6 +64,34 @@ int main(int argc, char *argv[]) {
                 case 'h':
                     height = parsed_arg;
                     break;
+                case 'n':
+                    if (parsed_arg > MAX_WORKERS)
+                        goto bad_syntax;
+                    workers = parsed_arg;
+                    break;
+                case 'q':
+                    if (parsed_arg > Worms::SendQueue::MAX_CAPACITY)
+                        goto bad_syntax;
+                    queue_capacity = parsed_arg;
+                    break;
+                case 'j':
+                    if (parsed_arg > MAX_ROOM_THREADS)
+                        goto bad_syntax;
+                    room_threads = parsed_arg;
+                    break;
+                case 'r':
+                    if (parsed_arg > MAX_ROOMS)
+                        goto bad_syntax;
+                    max_rooms = parsed_arg;
+                    break;
+                case 'c':
+                    max_catch_up_rounds = parsed_arg;
+                    break;
+                case 'M':
+                    if (parsed_arg > UINT16_MAX)
+                        goto bad_syntax;
+                    multicast_port = parsed_arg;
+                    break;
                 default:
                     goto bad_syntax;
             }
@@ -50,13 +99,34 @@ int main(int argc, char *argv[]) {
     }
     if (optind != argc) {
         bad_syntax:
-        fprintf(stderr, "Usage: %s [-p n] [-s n] [-t n] [-v n] [-w n] [-h n]\n",
+        fprintf(stderr, "Usage: %s [-p n] [-s n] [-t n] [-v n] [-w n] [-h n]"
+                        " [-b epoll|io_uring] [-n workers] [-q datagrams] [-j threads]"
+                        " [-r rooms] [-c rounds] [-m group[%%iface]] [-M port]\n",
                 argv[0]);
         exit(EXIT_FAILURE);
     }
 
 
-    Worms::Server server{port, seed, {turning_speed, rounds_per_sec, width, height}};
+    // By default, the server catches up with stalls of up to a second.
+    if (max_catch_up_rounds == 0)
+        max_catch_up_rounds = rounds_per_sec;
+
+    // Spectators bind the group's port, so by default it is the one next to the server's.
+    if (multicast_spec != nullptr) {
+        if (multicast_port == 0) {
+            // There is no port next to the last one, so it must be given.
+            if (port == UINT16_MAX)
+                goto bad_syntax;
+            multicast_port = port + 1;
+        }
+        multicast_group = Worms::parse_multicast_group(multicast_spec, multicast_port);
+        if (!multicast_group.has_value())
+            goto bad_syntax;
+    }
+
+    Worms::Server server{port, seed, {turning_speed, rounds_per_sec, width, height}, backend,
+                         workers, queue_capacity, room_threads, max_rooms,
+                         max_catch_up_rounds, multicast_group};
 
     server.mainloop();
 }
\ No newline at end of file
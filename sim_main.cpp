@@ -0,0 +1,163 @@
+#include <getopt.h>
+#include "cerrno"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Server/Simulator.h"
+
+static constexpr unsigned long const MAX_THREADS = 256;
+// Observers are told apart by ports, shared with players.
+static constexpr unsigned long const MAX_OBSERVERS = 60'000;
+
+namespace {
+    void write_file(std::string const& path, std::string const& contents) {
+        FILE* const file = fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            syserr(errno, "fopen %s", path.c_str());
+        if (fwrite(contents.data(), 1, contents.size(), file) != contents.size())
+            syserr(errno, "fwrite %s", path.c_str());
+        verify(fclose(file), "fclose");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    uint32_t seed = 1;
+    uint32_t turning_speed = 6;
+    uint32_t width = 640;
+    uint32_t height = 480;
+    unsigned long games = 1;
+    unsigned long threads = 1;
+    unsigned long bots = 2;
+    uint64_t max_rounds = 1'000'000;
+    char const* script_path = nullptr;
+    char const* output_dir = nullptr;
+    Worms::Audience audience;
+    unsigned long parsed_arg;
+
+    while ((opt = getopt(argc, argv, "s:t:w:h:g:j:n:r:i:o:a:m")) != -1) {
+        if (opt == '?') {
+            goto bad_syntax;
+        } else if (opt == 'i') {
+            script_path = optarg;
+        } else if (opt == 'o') {
+            output_dir = optarg;
+        } else if (opt == 'm') {
+            audience.multicast = true;
+        } else {
+            errno = 0;
+            char *badchar;
+            parsed_arg = strtoul(optarg, &badchar, 10);
+            if (*badchar != '\0' || errno != 0 || parsed_arg > UINT32_MAX || parsed_arg == 0)
+                goto bad_syntax;
+            switch (opt) {
+                case 's':
+                    seed = parsed_arg;
+                    break;
+                case 't':
+                    turning_speed = parsed_arg;
+                    break;
+                case 'w':
+                    width = parsed_arg;
+                    break;
+                case 'h':
+                    height = parsed_arg;
+                    break;
+                case 'g':
+                    games = parsed_arg;
+                    break;
+                case 'j':
+                    if (parsed_arg > MAX_THREADS)
+                        goto bad_syntax;
+                    threads = parsed_arg;
+                    break;
+                case 'n':
+                    if (parsed_arg < 2 || parsed_arg > UINT8_MAX)
+                        goto bad_syntax;
+                    bots = parsed_arg;
+                    break;
+                case 'r':
+                    max_rounds = parsed_arg;
+                    break;
+                case 'a':
+                    if (parsed_arg > MAX_OBSERVERS)
+                        goto bad_syntax;
+                    audience.observers = parsed_arg;
+                    break;
+                default:
+                    goto bad_syntax;
+            }
+        }
+    }
+    if (optind != argc) {
+        bad_syntax:
+        fprintf(stderr, "Usage: %s [-s n] [-t n] [-w n] [-h n] [-g games] [-j threads]"
+                        " [-n bots | -i script] [-r max_rounds] [-o output_dir]"
+                        " [-a observers] [-m]\n",
+                argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    Worms::Script script;
+    if (script_path != nullptr) {
+        FILE* const file = fopen(script_path, "r");
+        if (file == nullptr)
+            syserr(errno, "fopen %s", script_path);
+        script = Worms::Script::read(file);
+        fclose(file);
+    } else {
+        script = Worms::Script::bots(bots);
+    }
+
+    // Game i is seeded with seed + i, whichever thread plays it.
+    Worms::GameConstants const constants{turning_speed, 1, width, height};
+    std::vector<Worms::SimulationResult> results(games);
+    std::atomic<size_t> next_game{0};
+    auto const play = [&] {
+        for (size_t i; (i = next_game++) < games;) {
+            results[i] = Worms::simulate(constants, seed + static_cast<uint32_t>(i),
+                                         script, max_rounds, audience);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned long i = 1; i < std::min(threads, games); ++i) {
+        workers.emplace_back(play);
+    }
+    play();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (size_t i = 0; i < games; ++i) {
+        auto const& result = results[i];
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        for (uint64_t const ns : result.round_ns) {
+            total_ns += ns;
+            max_ns = std::max(max_ns, ns);
+        }
+        printf("game %zu: seed %u, id %u, %lu rounds, %zu events, log crc32 %08x, "
+               "%.0f ns per round (at most %lu)\n",
+               i, result.seed, result.game_id, result.rounds, result.events,
+               Worms::Crc32Computer::compute_in_buffer(result.log.data(), result.log.size()),
+               result.rounds == 0 ? 0.0 : static_cast<double>(total_ns) / result.rounds,
+               max_ns);
+        printf("game %zu: egress %lu datagrams, %lu bytes (%zu observers, %s)\n",
+               i, result.egress_datagrams, result.egress_bytes, audience.observers,
+               audience.multicast ? "multicast" : "unicast");
+
+        if (output_dir != nullptr) {
+            std::string const prefix = std::string{output_dir} + "/game-" + std::to_string(i);
+            write_file(prefix + ".events", result.log);
+            std::string timings;
+            for (uint64_t const ns : result.round_ns) {
+                timings += std::to_string(ns);
+                timings += '\n';
+            }
+            write_file(prefix + ".rounds", timings);
+        }
+    }
+}
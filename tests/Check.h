@@ -0,0 +1,14 @@
+#ifndef ROBAKI_CHECK_H
+#define ROBAKI_CHECK_H
+
+#include "../Common/err.h"
+
+/* Fails the test, with the condition and where it was checked, unless it holds.
+ * Unlike assert(), it is not compiled out of optimized builds. */
+#define CHECK(condition) \
+do { \
+    if (!(condition)) \
+        fatal("%s:%d: check failed: %s", __FILE__, __LINE__, #condition); \
+} while (0)
+
+#endif //ROBAKI_CHECK_H
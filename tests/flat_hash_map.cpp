@@ -0,0 +1,123 @@
+#include <unordered_map>
+
+#include "../Server/ClientData.h"
+#include "../Server/FlatHashMap.h"
+#include "../Server/RandomGenerator.h"
+#include "Check.h"
+
+namespace {
+    // Few distinct hashes, so that runs of entries are long and wrap around the array.
+    struct CollidingHash {
+        size_t operator()(uint32_t const key) const {
+            return key % 7;
+        }
+    };
+
+    struct ConstantHash {
+        size_t operator()(uint32_t) const {
+            return 0;
+        }
+    };
+
+    template<typename Map>
+    void check_same(Map const& map, std::unordered_map<uint32_t, uint32_t> const& expected) {
+        CHECK(map.size() == expected.size());
+        size_t visited = 0;
+        for (auto const& [key, value] : map) {
+            auto const it = expected.find(key);
+            CHECK(it != expected.end() && it->second == value);
+            ++visited;
+        }
+        CHECK(visited == expected.size());
+    }
+
+    /* Inserts, finds and erases random keys, comparing every result with std::unordered_map.
+     * With keys drawn from a small range, most erasures shift entries back. */
+    template<typename Hash>
+    void check_churn(uint32_t const keys, uint32_t const steps, uint32_t const seed) {
+        Worms::FlatHashMap<uint32_t, uint32_t, Hash> map;
+        std::unordered_map<uint32_t, uint32_t> expected;
+        Worms::RandomGenerator rand{seed};
+        for (uint32_t step = 0; step < steps; ++step) {
+            uint32_t const key = rand() % keys;
+            switch (rand() % 3) {
+                case 0: {
+                    // An existing value is kept, as by emplace().
+                    uint32_t const& value = map.insert(key, step);
+                    CHECK(value == expected.emplace(key, step).first->second);
+                    break;
+                }
+                case 1:
+                    CHECK(map.erase(key) == (expected.erase(key) == 1));
+                    break;
+                default: {
+                    uint32_t const* value = map.find(key);
+                    auto const it = expected.find(key);
+                    CHECK((value == nullptr) == (it == expected.end()));
+                    CHECK(value == nullptr || *value == it->second);
+                    CHECK(map.contains(key) == (value != nullptr));
+                }
+            }
+            CHECK(map.size() == expected.size());
+            if (step % 4096 == 0)
+                check_same(map, expected);
+        }
+        check_same(map, expected);
+
+        // Emptying the map leaves no stale entries behind.
+        for (uint32_t key = 0; key < keys; ++key) {
+            map.erase(key);
+        }
+        CHECK(map.empty());
+        CHECK(!(map.begin() != map.end()));
+    }
+
+    Worms::Endpoint endpoint(uint32_t const i) {
+        sockaddr_in6 address{};
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_loopback;
+        address.sin6_addr.s6_addr[8] = static_cast<uint8_t>(i >> 16);
+        address.sin6_port = htobe16(static_cast<uint16_t>(i));
+        return Worms::Endpoint::of(address);
+    }
+
+    /* Clients keyed by endpoints, as the server keeps them, in numbers far beyond
+     * the initial capacity, so that the map rehashes many times while in use. */
+    void check_many_endpoints() {
+        constexpr uint32_t const CLIENTS = 50'000;
+        Worms::FlatHashMap<Worms::Endpoint, uint32_t, Worms::Endpoint::Hash> map;
+        for (uint32_t i = 0; i < CLIENTS; ++i) {
+            map.insert(endpoint(i), i);
+        }
+        CHECK(map.size() == CLIENTS);
+        for (uint32_t i = 0; i < CLIENTS; ++i) {
+            uint32_t const* value = map.find(endpoint(i));
+            CHECK(value != nullptr && *value == i);
+        }
+
+        for (uint32_t i = 0; i < CLIENTS; i += 2) {
+            CHECK(map.erase(endpoint(i)));
+        }
+        CHECK(map.size() == CLIENTS / 2);
+        for (uint32_t i = 0; i < CLIENTS; ++i) {
+            CHECK(map.contains(endpoint(i)) == (i % 2 == 1));
+        }
+
+        for (uint32_t i = 0; i < CLIENTS; i += 2) {
+            map.insert(endpoint(i), i + CLIENTS);
+        }
+        for (uint32_t i = 0; i < CLIENTS; ++i) {
+            uint32_t const* value = map.find(endpoint(i));
+            CHECK(value != nullptr && *value == (i % 2 == 1 ? i : i + CLIENTS));
+        }
+    }
+}
+
+int main() {
+    check_churn<std::hash<uint32_t>>(5'000, 1'000'000, 1);
+    // Around 10k entries at once.
+    check_churn<std::hash<uint32_t>>(20'000, 1'000'000, 2);
+    check_churn<CollidingHash>(2'000, 200'000, 3);
+    check_churn<ConstantHash>(200, 100'000, 4);
+    check_many_endpoints();
+}
@@ -0,0 +1,81 @@
+#include <ctgmath>
+
+#include "../Server/Board.h"
+#include "../Server/RandomGenerator.h"
+#include "../Server/Simulator.h"
+#include "Check.h"
+
+namespace {
+    /* Games whose event logs were recorded with worms moved by std::cos and std::sin
+     * of the angle in every round, as they were before the table of directions. */
+    struct Golden {
+        uint32_t seed;
+        uint32_t turning_speed;
+        uint32_t width;
+        uint32_t height;
+        size_t bots;
+        uint64_t rounds;
+        uint32_t log_crc32;
+    };
+
+    constexpr Golden const GOLDEN[] = {
+            {1, 6, 640, 480, 2, 13, 0xd58ab858},
+            {2, 6, 640, 480, 8, 243, 0x5f7c0681},
+            {3, 1, 800, 600, 4, 408, 0x5025a994},
+            {4, 13, 1920, 1080, 6, 87, 0xdbf5528c},
+            {5, 90, 640, 480, 3, 23, 0xd3b9cd66},
+            {6, 7, 4000, 4000, 16, 274, 0xb83ea7ff},
+    };
+
+    void check_directions() {
+        for (uint16_t i = 0; i < Worms::angle_t::MAX_ANGLE; ++i) {
+            Worms::angle_t const angle{i};
+            CHECK(angle.direction().first == std::cos(angle.to_radians()));
+            CHECK(angle.direction().second == std::sin(angle.to_radians()));
+        }
+    }
+
+    /* Walks far longer than any game, so that rounding errors would pile up,
+     * comparing every pixel with a walk computing the direction each step. */
+    void check_walks() {
+        Worms::RandomGenerator rand{42};
+        for (int walk = 0; walk < 16; ++walk) {
+            // Far enough from the edges not to reach negative coordinates.
+            double x = (1 << 20) + rand() % 4096 + 0.5;
+            double y = (1 << 20) + rand() % 4096 + 0.5;
+            Worms::Position position{x, y};
+            Worms::angle_t angle = rand() % 360;
+            uint16_t const turning_speed = 1 + rand() % 90;
+            for (int step = 0; step < 100'000; ++step) {
+                uint32_t const turn = rand() % 3;
+                if (turn == Worms::RIGHT)
+                    angle += turning_speed;
+                else if (turn == Worms::LEFT)
+                    angle -= turning_speed;
+                position.move_with_angle(angle);
+                x += std::cos(angle.to_radians());
+                y += std::sin(angle.to_radians());
+                CHECK(position.as_pixel() == (Worms::Pixel{static_cast<uint32_t>(x),
+                                                           static_cast<uint32_t>(y)}));
+            }
+        }
+    }
+
+    void check_games() {
+        for (auto const& golden : GOLDEN) {
+            Worms::GameConstants const constants{golden.turning_speed, 1,
+                                                 golden.width, golden.height};
+            auto const result = Worms::simulate(constants, golden.seed,
+                                                Worms::Script::bots(golden.bots), 1'000'000);
+            CHECK(result.rounds == golden.rounds);
+            CHECK(Worms::Crc32Computer::compute_in_buffer(result.log.data(), result.log.size())
+                  == golden.log_crc32);
+        }
+    }
+}
+
+int main() {
+    check_directions();
+    check_walks();
+    check_games();
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "../Common/ClientHeartbeat.h"
+#include "../Server/RandomGenerator.h"
+#include "Check.h"
+
+namespace {
+    constexpr size_t const MAX_NAME_LENGTH = 20;
+    // Bytes around the edges of printable ASCII, and those with the high bit set.
+    constexpr unsigned char const EDGES[] = {0, 1, 31, 32, 33, 34, 125, 126, 127, 128, 129, 255};
+
+    /* Name checked one character at a time. */
+    bool naive_is_valid(std::string const& name) {
+        return name.size() <= MAX_NAME_LENGTH &&
+               std::all_of(name.begin(), name.end(), [](char const c) {
+                   return static_cast<unsigned char>(c) >= 33 && static_cast<unsigned char>(c) <= 126;
+               });
+    }
+
+    bool is_valid(std::string const& name) {
+        bool const valid = Worms::ClientHeartbeatView::is_valid_name(name);
+        CHECK(valid == naive_is_valid(name));
+        return valid;
+    }
+
+    void check_lengths() {
+        CHECK(is_valid(""));
+        for (size_t length = 1; length <= MAX_NAME_LENGTH; ++length) {
+            CHECK(is_valid(std::string(length, '!')));
+            CHECK(is_valid(std::string(length, '~')));
+        }
+        CHECK(!is_valid(std::string(MAX_NAME_LENGTH + 1, 'a')));
+        CHECK(!is_valid(std::string(64, 'a')));
+    }
+
+    /* Every byte value at every position of names of every length, so that each byte
+     * of the first, middle and last, partial, word is checked. */
+    void check_every_byte() {
+        for (size_t length = 1; length <= MAX_NAME_LENGTH; ++length) {
+            for (size_t pos = 0; pos < length; ++pos) {
+                for (unsigned byte = 0; byte < 256; ++byte) {
+                    std::string name(length, 'a');
+                    name[pos] = static_cast<char>(byte);
+                    CHECK(is_valid(name) == (byte >= 33 && byte <= 126));
+                }
+            }
+        }
+    }
+
+    /* Adjacent pairs of edge bytes, as borrows and carries of the word-wide arithmetic
+     * cross from one byte to the next, word boundaries included. */
+    void check_neighbours() {
+        for (size_t pos = 0; pos + 1 < MAX_NAME_LENGTH; ++pos) {
+            for (unsigned char const first : EDGES) {
+                for (unsigned char const second : EDGES) {
+                    std::string name(MAX_NAME_LENGTH, 'a');
+                    name[pos] = static_cast<char>(first);
+                    name[pos + 1] = static_cast<char>(second);
+                    is_valid(name);
+                }
+            }
+        }
+    }
+
+    void check_random() {
+        Worms::RandomGenerator rand{5};
+        for (int i = 0; i < 200'000; ++i) {
+            std::string name(rand() % (MAX_NAME_LENGTH + 3), 'a');
+            for (char& c : name) {
+                c = static_cast<char>(rand() % 2 == 0 ? EDGES[rand() % std::size(EDGES)]
+                                                      : 33 + rand() % 94);
+            }
+            is_valid(name);
+        }
+    }
+
+    /* Names are split at the first '\0', each of them validated on its own. */
+    void check_parsed_names() {
+        Worms::UDPReceiveRing ring{-1, 1};
+        auto const parse = [&ring](std::string const& names) {
+            std::string datagram(sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint32_t), '\0');
+            datagram += names;
+            ring.store(0, sockaddr_in6{}, datagram.data(), datagram.size());
+            return Worms::ClientHeartbeatView{ring.slot(0)};
+        };
+
+        auto heartbeat = parse("player");
+        CHECK(heartbeat.player_name == "player" && heartbeat.room.empty());
+        CHECK(heartbeat.has_valid_player_name());
+
+        heartbeat = parse(std::string{"player\0room", 11});
+        CHECK(heartbeat.player_name == "player" && heartbeat.room == "room");
+        CHECK(heartbeat.has_valid_player_name());
+
+        // A second separator is a part of the room's name, which makes it invalid.
+        heartbeat = parse(std::string{"player\0ro\0om", 12});
+        CHECK(heartbeat.room == std::string_view("ro\0om", 5));
+        CHECK(!heartbeat.has_valid_player_name());
+
+        heartbeat = parse(std::string{"player\0", 7} + std::string(MAX_NAME_LENGTH + 1, 'r'));
+        CHECK(!heartbeat.has_valid_player_name());
+    }
+}
+
+int main() {
+    check_lengths();
+    check_every_byte();
+    check_neighbours();
+    check_random();
+    check_parsed_names();
+}
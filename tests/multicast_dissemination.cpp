@@ -0,0 +1,123 @@
+#include <map>
+#include <string>
+
+#include "../Common/Multicast.h"
+#include "../Server/Game.h"
+#include "Check.h"
+
+namespace {
+    constexpr size_t const PLAYERS = 3;
+    constexpr uint16_t const GROUP_PORT = 2022;
+
+    struct Received {
+        uint64_t datagrams = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Egress {
+        // By destination port: players and observers are told apart by ports.
+        std::map<uint16_t, Received> by_port;
+        uint64_t datagrams = 0;
+        std::string log;
+    };
+
+    sockaddr_in6 client_address(uint16_t const port) {
+        sockaddr_in6 address{};
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_loopback;
+        address.sin6_port = htobe16(port);
+        return address;
+    }
+
+    /* Plays a game of bots watched by observers, disseminating its events after every
+     * round, as rooms do, and tallies datagrams by their destinations. */
+    Egress play(size_t const observers, std::optional<sockaddr_in6> const& group) {
+        Worms::GameConstants const constants{6, 50, 200, 200};
+        Worms::RandomGenerator rand{11};
+        Worms::Board board{constants};
+        Worms::GameArena arena;
+        Worms::ClientSlots clients;
+        std::vector<Worms::ClientHandle> players;
+        for (size_t i = 0; i < PLAYERS; ++i) {
+            Worms::Player player{"bot" + std::to_string(i), Worms::STRAIGHT};
+            player.got_ready();
+            players.push_back(clients.insert(Worms::ClientData{
+                    client_address(static_cast<uint16_t>(i + 1)), 0, 0, std::move(player)}));
+        }
+        for (size_t i = 0; i < observers; ++i) {
+            clients.insert(Worms::ClientData{
+                    client_address(static_cast<uint16_t>(PLAYERS + i + 1)), 0, 0,
+                    Worms::Player{"", Worms::STRAIGHT}});
+        }
+
+        Worms::Game game{constants, board, arena, rand, clients};
+        Worms::SendQueue queue;
+        Egress egress;
+        for (int round = 0; round < 1000 && !game.finished(); ++round) {
+            for (auto const handle : players) {
+                clients.get(handle)->player.turn_direction = round / 16 % 3;
+            }
+            game.play_round();
+            game.disseminate_new_events(queue, group.has_value() ? &*group : nullptr);
+            for (; !queue.empty(); queue.pop_front()) {
+                Received& received = egress.by_port[be16toh(queue[0].destination.sin6_port)];
+                ++received.datagrams;
+                received.bytes += queue[0].size();
+                ++egress.datagrams;
+            }
+        }
+        CHECK(game.finished());
+        game.events().dump(egress.log);
+        return egress;
+    }
+
+    void check_dissemination() {
+        auto const group = Worms::parse_multicast_group("ff15::4242", GROUP_PORT);
+        CHECK(group.has_value());
+
+        Egress const unicast = play(100, std::nullopt);
+        Egress const published = play(100, group);
+        Egress const unwatched = play(0, group);
+
+        // Players get every datagram directly either way; observers only without a group,
+        // which gets a single copy of what a player gets instead.
+        Received const& player = unicast.by_port.at(1);
+        CHECK(player.datagrams > 0);
+        CHECK(unicast.by_port.size() == PLAYERS + 100);
+        CHECK(unicast.by_port.at(PLAYERS + 1).datagrams == player.datagrams);
+        CHECK(published.by_port.size() == PLAYERS + 1);
+        for (uint16_t port = 1; port <= PLAYERS; ++port) {
+            CHECK(published.by_port.at(port).bytes == player.bytes);
+        }
+        CHECK(published.by_port.at(GROUP_PORT).datagrams == player.datagrams);
+        CHECK(published.by_port.at(GROUP_PORT).bytes == player.bytes);
+
+        // Egress of a published game does not depend on its audience, nor does the game.
+        CHECK(unicast.datagrams == (PLAYERS + 100) * player.datagrams);
+        CHECK(published.datagrams == (PLAYERS + 1) * player.datagrams);
+        CHECK(unwatched.datagrams == published.datagrams);
+        CHECK(unicast.log == published.log && published.log == unwatched.log);
+    }
+
+    void check_group_parsing() {
+        auto const group = Worms::parse_multicast_group("ff15::4242", GROUP_PORT);
+        CHECK(group.has_value());
+        CHECK(be16toh(group->sin6_port) == GROUP_PORT);
+        CHECK(group->sin6_scope_id == 0);
+
+        auto const scoped = Worms::parse_multicast_group("ff02::4242%lo", GROUP_PORT);
+        CHECK(scoped.has_value() && scoped->sin6_scope_id == if_nametoindex("lo"));
+
+        // Unicast addresses, unknown interfaces and garbage are refused.
+        CHECK(!Worms::parse_multicast_group("2001:db8::1", GROUP_PORT).has_value());
+        CHECK(!Worms::parse_multicast_group("::1", GROUP_PORT).has_value());
+        CHECK(!Worms::parse_multicast_group("ff02::4242%no-such-iface", GROUP_PORT).has_value());
+        CHECK(!Worms::parse_multicast_group("239.1.2.3", GROUP_PORT).has_value());
+        CHECK(!Worms::parse_multicast_group("", GROUP_PORT).has_value());
+    }
+}
+
+int main() {
+    check_dissemination();
+    check_group_parsing();
+}
@@ -0,0 +1,63 @@
+#include "../Common/Buffer.h"
+#include "Check.h"
+
+namespace {
+    Worms::QueuedDatagram datagram(uint16_t const port, bool const live) {
+        Worms::QueuedDatagram queued{};
+        queued.destination.sin6_family = AF_INET6;
+        queued.destination.sin6_port = htobe16(port);
+        queued.live = live;
+        return queued;
+    }
+
+    /* Catch-up datagrams are dropped first, pinned ones never, and live ones only
+     * once the queue has grown to its maximum capacity. */
+    void check_ceiling() {
+        Worms::SendQueue queue{4, 16};
+        CHECK(queue.capacity() == 4);
+        queue.push_back(datagram(0, false));
+        queue.push_back(datagram(1, false));
+        queue.pin_front(1);
+        for (uint16_t port = 2; port < 5; ++port) {
+            queue.push_back(datagram(port, true));
+        }
+        // The unpinned catch-up datagram made room for the last live one.
+        CHECK(queue.capacity() == 4 && queue.size() == 4);
+        CHECK(be16toh(queue[0].destination.sin6_port) == 0);
+        CHECK(queue[1].live);
+
+        for (uint16_t port = 5; port < 40; ++port) {
+            queue.push_back(datagram(port, true));
+        }
+        CHECK(queue.capacity() == 16 && queue.size() == 16);
+        // Datagrams beyond the ceiling are the ones dropped; the queue keeps its order.
+        CHECK(be16toh(queue[15].destination.sin6_port) == 16);
+        queue.push_back(datagram(40, false));
+        CHECK(queue.size() == 16);
+
+        auto const counters = queue.take_counters();
+        CHECK(counters.dropped == 1 + 23 + 1);
+        CHECK(counters.dropped_live == 23);
+        CHECK(counters.live == 38 - 23 && counters.catch_up == 2);
+        CHECK(counters.high_water == 16);
+    }
+
+    void check_capacities() {
+        // The initial capacity is cut down to the maximum one; both are rounded up.
+        CHECK(Worms::SendQueue(100, 5).capacity() == 8);
+        CHECK(Worms::SendQueue(3, 5).capacity() == 4);
+        CHECK(Worms::SendQueue(0).capacity() == 1);
+        CHECK(Worms::SendQueue().capacity() == Worms::SendQueue::DEFAULT_CAPACITY);
+
+        Worms::SendQueue queue{1, 1};
+        queue.push_back(datagram(0, true));
+        queue.push_back(datagram(1, true));
+        CHECK(queue.capacity() == 1 && queue.size() == 1);
+        CHECK(queue.take_counters().dropped_live == 1);
+    }
+}
+
+int main() {
+    check_ceiling();
+    check_capacities();
+}
@@ -0,0 +1,97 @@
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../Server/RandomGenerator.h"
+#include "../Server/SlotMap.h"
+#include "Check.h"
+
+namespace {
+    using Map = Worms::SlotMap<std::string>;
+
+    void check_stale_handles() {
+        Map map;
+        Map::Handle const first = map.insert("first");
+        Map::Handle const second = map.insert("second");
+        CHECK(map.size() == 2);
+        CHECK(*map.get(first) == "first" && *map.get(second) == "second");
+
+        // A default handle, or one beyond all slots, refers to nothing.
+        CHECK(map.get(Map::Handle{}) == nullptr);
+        CHECK(map.get(Map::Handle{7, 0}) == nullptr);
+        CHECK(!map.erase(Map::Handle{}));
+
+        CHECK(map.erase(first));
+        CHECK(map.get(first) == nullptr);
+        CHECK(!map.erase(first));
+        CHECK(map.size() == 1);
+        // The last value has moved into the hole, yet its handle still finds it.
+        CHECK(*map.get(second) == "second");
+
+        // The slot is reused with the next generation, so the old handle stays stale.
+        Map::Handle const third = map.insert("third");
+        CHECK(third.index == first.index);
+        CHECK(third.generation != first.generation);
+        CHECK(!(third == first));
+        CHECK(map.get(first) == nullptr);
+        CHECK(*map.get(third) == "third");
+        CHECK(!map.erase(first));
+        CHECK(map.size() == 2);
+    }
+
+    void check_dense_order() {
+        Map map;
+        std::vector<Map::Handle> handles;
+        for (int i = 0; i < 10; ++i) {
+            handles.push_back(map.insert(std::to_string(i)));
+        }
+        for (int i = 0; i < 10; i += 3) {
+            CHECK(map.erase(handles[i]));
+        }
+        // Remaining values are dense and each knows its handle.
+        CHECK(map.size() == 6);
+        size_t visited = 0;
+        for (auto const& value : map) {
+            CHECK(*map.get(map.handle_at(visited)) == value);
+            CHECK(&map[visited] == map.get(map.handle_at(visited)));
+            ++visited;
+        }
+        CHECK(visited == map.size());
+    }
+
+    /* Inserts and erases at random, comparing with handles kept aside, so that slots
+     * get reused many times; handles of erased values must never come back to life. */
+    void check_churn() {
+        Worms::SlotMap<uint32_t> map;
+        std::map<uint32_t, Worms::SlotMap<uint32_t>::Handle> live;
+        std::vector<Worms::SlotMap<uint32_t>::Handle> dead;
+        Worms::RandomGenerator rand{1};
+        uint32_t next = 0;
+        for (int step = 0; step < 200'000; ++step) {
+            if (rand() % 3 != 0 && live.size() < 500) {
+                live.emplace(next, map.insert(next));
+                ++next;
+            } else if (!live.empty()) {
+                auto it = live.begin();
+                std::advance(it, rand() % live.size());
+                CHECK(map.erase(it->second));
+                dead.push_back(it->second);
+                live.erase(it);
+            }
+            CHECK(map.size() == live.size());
+        }
+        for (auto const& [value, handle] : live) {
+            CHECK(map.get(handle) != nullptr && *map.get(handle) == value);
+        }
+        for (auto const& handle : dead) {
+            CHECK(map.get(handle) == nullptr);
+        }
+    }
+}
+
+int main() {
+    check_stale_handles();
+    check_dense_order();
+    check_churn();
+}
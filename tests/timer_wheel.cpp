@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "../Server/RandomGenerator.h"
+#include "../Server/TimerWheel.h"
+#include "Check.h"
+
+namespace {
+    using Wheel = Worms::TimerWheel<int>;
+
+    std::vector<int> expire(Wheel& wheel, uint64_t const round_no) {
+        std::vector<int> expired;
+        wheel.expire(round_no, expired);
+        std::sort(expired.begin(), expired.end());
+        return expired;
+    }
+
+    void check_wrap() {
+        // 8 rounds of horizon make a wheel of 16 buckets.
+        Wheel wheel{8};
+        wheel.arm(1, 3);
+        wheel.arm(2, 3 + 16);
+        wheel.arm(3, 3 + 2 * 16);
+        CHECK(expire(wheel, 2).empty());
+        CHECK(expire(wheel, 3) == std::vector<int>{1});
+        // Later deadlines share the bucket, yet are passed over until they come.
+        CHECK(expire(wheel, 18).empty());
+        CHECK(expire(wheel, 19) == std::vector<int>{2});
+        // Skipping more rounds than there are buckets visits each bucket once.
+        CHECK(expire(wheel, 100) == std::vector<int>{3});
+        // Rounds already swept are not swept again.
+        CHECK(expire(wheel, 100).empty());
+        CHECK(expire(wheel, 50).empty());
+    }
+
+    void check_rearm_and_cancel() {
+        Wheel wheel{8};
+        Wheel::Timer const later = wheel.arm(1, 5);
+        Wheel::Timer const sooner = wheel.arm(2, 5);
+        Wheel::Timer const cancelled = wheel.arm(3, 5);
+        wheel.rearm(later, 7);
+        wheel.rearm(sooner, 2);
+        wheel.cancel(cancelled);
+        CHECK(expire(wheel, 2) == std::vector<int>{2});
+        CHECK(expire(wheel, 6).empty());
+        CHECK(expire(wheel, 7) == std::vector<int>{1});
+
+        // An expired timer can be armed again, like that of a client that came back.
+        wheel.rearm(later, 9);
+        CHECK(expire(wheel, 9) == std::vector<int>{1});
+
+        // Re-arming to the same deadline keeps a single entry.
+        Wheel::Timer const twice = wheel.arm(4, 12);
+        wheel.rearm(twice, 12);
+        wheel.rearm(twice, 12);
+        CHECK(expire(wheel, 12) == std::vector<int>{4});
+
+        // A cancelled timer is reused for the next one, with nothing of the old one left.
+        wheel.cancel(later);
+        wheel.cancel(sooner);
+        wheel.cancel(twice);
+        Wheel::Timer const reused = wheel.arm(5, 14);
+        CHECK(reused == twice);
+        CHECK(expire(wheel, 14) == std::vector<int>{5});
+    }
+
+    /* Arms, re-arms, cancels and expires timers at random, comparing what expires
+     * with deadlines kept aside; rounds sometimes jump past the whole wheel. */
+    void check_churn() {
+        constexpr uint64_t const HORIZON = 37;
+        Wheel wheel{HORIZON};
+        std::map<int, std::pair<Wheel::Timer, uint64_t>> armed;
+        Worms::RandomGenerator rand{3};
+        uint64_t round_no = 0;
+        int next = 0;
+        auto const pick = [&] {
+            auto it = armed.begin();
+            std::advance(it, rand() % armed.size());
+            return it;
+        };
+
+        for (int step = 0; step < 300'000; ++step) {
+            uint32_t const operation = rand() % 10;
+            uint64_t const deadline = round_no + 1 + rand() % HORIZON;
+            if (operation < 3) {
+                armed[next] = {wheel.arm(next, deadline), deadline};
+                ++next;
+            } else if (operation < 6 && !armed.empty()) {
+                auto const it = pick();
+                wheel.rearm(it->second.first, deadline);
+                it->second.second = deadline;
+            } else if (operation < 7 && !armed.empty()) {
+                auto const it = pick();
+                wheel.cancel(it->second.first);
+                armed.erase(it);
+            } else {
+                round_no += rand() % 20 == 0 ? rand() % 100 : 1;
+                std::vector<int> due;
+                for (auto const& [key, timer] : armed) {
+                    if (timer.second <= round_no)
+                        due.push_back(key);
+                }
+                std::vector<int> const expired = expire(wheel, round_no);
+                CHECK(expired == due);
+                for (int const key : expired) {
+                    wheel.cancel(armed[key].first);
+                    armed.erase(key);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    check_wrap();
+    check_rearm_and_cancel();
+    check_churn();
+}